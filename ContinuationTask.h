@@ -0,0 +1,110 @@
+#pragma once
+/*******************************************************************************
+Header file for the ContinuationTask class.
+*******************************************************************************/
+
+#include <RTL_StdLib.h>
+#include "TaskBase.h"
+
+
+//******************************************************************************
+/// The base class for a task whose work spans several TaskManager passes.
+///
+/// A ContinuationTask implements PollWork() as one sequential block of code
+/// between TASK_BEGIN() and TASK_END(), with TASK_YIELD() or TASK_YIELD_IF_DUE()
+/// at the points where it may give up the processor. When the task yields,
+/// PollWork() returns and the next call continues after the yield point, so a
+/// long computation runs in slices without hand written chunking. Reaching
+/// TASK_END() completes the work; the next call starts again at TASK_BEGIN().
+///
+/// Example:
+///
+///     class PathSmoother : public ContinuationTask
+///     {
+///         bool PollWork() override
+///         {
+///             if (!_hasNewPath) return false;
+///
+///             TASK_BEGIN();
+///
+///             for (_i = 1; _i < _pointCount - 1; _i++)
+///             {
+///                 Smooth(_i);
+///                 TASK_YIELD_IF_DUE();
+///             }
+///
+///             _hasNewPath = false;
+///
+///             TASK_END();
+///         };
+///
+///         uint16_t _i;
+///     };
+///
+/// A yielding task reports that it did work, so it is not backed off, and in
+/// SignaledOnly dispatch mode it signals itself so that it runs on the next
+/// pass. A yielding dataflow consumer also runs on the next pass even if its
+/// producers have not changed.
+/// ============================================================================
+/// IMPORTANT: Local variables are *NOT* preserved across a yield. Keep any
+/// state the work needs after a yield (e.g., loop counters) in members. A
+/// switch statement cannot enclose a yield point.
+//******************************************************************************
+class ContinuationTask : public TaskBase
+{
+    /*--------------------------------------------------------------------------
+    Constructors
+    --------------------------------------------------------------------------*/
+    protected: ContinuationTask() : _resumePoint(0) { };
+
+    protected: ContinuationTask(TaskState startingState) : TaskBase(startingState), _resumePoint(0) { };
+
+    /*--------------------------------------------------------------------------
+    Public interface
+    --------------------------------------------------------------------------*/
+    //**************************************************************************
+    /// Determines if the task yielded before completing its work.
+    //**************************************************************************
+    public: bool IsContinuing() { return _resumePoint != 0; };
+
+    //**************************************************************************
+    /// Abandons the work in progress so the next call starts at TASK_BEGIN().
+    //**************************************************************************
+    public: void Restart() { _resumePoint = 0; };
+
+    /*--------------------------------------------------------------------------
+    Overrides
+    --------------------------------------------------------------------------*/
+    public: const __FlashStringHelper* Name() override { return F("ContinuationTask"); };
+
+    /*--------------------------------------------------------------------------
+    Internal implementation
+    --------------------------------------------------------------------------*/
+    /// Makes sure the task runs again on the next pass after yielding, even if
+    /// it is a dataflow consumer whose producers have not changed
+    protected: void Continue()
+    {
+#if TASKSCHEDULER_DATAFLOW
+        MarkInputsStale();
+#endif
+#if TASKSCHEDULER_SIGNALS
+        Signal();
+#endif
+    };
+
+    /// The line number of the yield point to continue from (0 = start)
+    protected: uint16_t _resumePoint;
+};
+
+
+/// Starts the resumable body of ContinuationTask::PollWork().
+#define TASK_BEGIN()            switch (_resumePoint) { case 0:
+
+/// Returns from PollWork() and continues from this point on the next call.
+#define TASK_YIELD()            do { _resumePoint = __LINE__; Continue(); return true; case __LINE__:; } while (0)
+
+/// Yields only if the current pass has used up its time budget.
+#define TASK_YIELD_IF_DUE()     do { if (ShouldYield()) TASK_YIELD(); } while (0)
+
+/// Ends the resumable body of ContinuationTask::PollWork().
+#define TASK_END()              } _resumePoint = 0; return true
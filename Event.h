@@ -3,6 +3,7 @@
 
 #include <inttypes.h>
 #include <RTL_Variant.h>
+#include "TaskSchedulerConfig.h"
 
 
 typedef uint16_t EVENT_ID;
@@ -11,40 +12,106 @@ typedef uint16_t EVENT_ID;
 class EventSource;
 
 
-struct Event            // size = 8?
+#if TASKSCHEDULER_COMPACT
+/// Event payload in the compact profile.
+union event_data_t      // size = 2
+{
+    int16_t  Int;
+    uint16_t UnsignedInt;
+    bool     Bool;
+#if defined(__AVR__)
+    void*    Pointer;   // Pointers are 2 bytes on AVR
+#endif
+};
+#else
+typedef variant_union_t event_data_t;
+#endif
+
+
+struct Event            // size = 8 (compact = 5)
 {
     /**************************************************************************
     Constructors
     **************************************************************************/
-    Event() : EventID(0) { Data.Long = 0; };
+#if TASKSCHEDULER_COMPACT
+    Event() : EventID(0), SourceIndex(0) { Data.UnsignedInt = 0; };
+
+    Event(EVENT_ID eventID, int32_t data=0) : EventID(eventID), SourceIndex(0) { Data.Int = (int16_t)data; };
+
+    Event(EVENT_ID eventID, int16_t data)   : EventID(eventID), SourceIndex(0) { Data.Int = data; };
+
+    Event(EVENT_ID eventID, uint32_t data)  : EventID(eventID), SourceIndex(0) { Data.UnsignedInt = (uint16_t)data; };
+
+    Event(EVENT_ID eventID, uint16_t data)  : EventID(eventID), SourceIndex(0) { Data.UnsignedInt = data; };
+
+    Event(EVENT_ID eventID, bool data)      : EventID(eventID), SourceIndex(0) { Data.UnsignedInt = 0; Data.Bool = data; };
+
+#if defined(__AVR__)
+    Event(EVENT_ID eventID, void* pData)    : EventID(eventID), SourceIndex(0) { Data.Pointer = pData; };
+#endif
+
+    Event(EVENT_ID eventID, variant_t data) : EventID(eventID), SourceIndex(0) { variant_union_t v = data; Data.UnsignedInt = v.UnsignedInt; };
 
-    Event(EVENT_ID eventID, int32_t data=0) : EventID(eventID) { Data.Long = data; };
+    Event(EVENT_ID eventID, variant_union_t data) : EventID(eventID), SourceIndex(0) { Data.UnsignedInt = data.UnsignedInt; };
 
-    Event(EVENT_ID eventID, int16_t data)   : EventID(eventID) { Data.Int = data; };
+    // Copy constructor
+    Event(const Event& rhs) : EventID(rhs.EventID), Data(rhs.Data), SourceIndex(rhs.SourceIndex) {  };
+#else
+    Event() : EventID(0), Source(nullptr) { Data.Long = 0; };
+
+    Event(EVENT_ID eventID, int32_t data=0) : EventID(eventID), Source(nullptr) { Data.Long = data; };
 
-    Event(EVENT_ID eventID, uint32_t data)  : EventID(eventID) { Data.UnsignedLong = data; };
+    Event(EVENT_ID eventID, int16_t data)   : EventID(eventID), Source(nullptr) { Data.Int = data; };
 
-    Event(EVENT_ID eventID, uint16_t data)  : EventID(eventID) { Data.UnsignedInt = data; };
+    Event(EVENT_ID eventID, uint32_t data)  : EventID(eventID), Source(nullptr) { Data.UnsignedLong = data; };
 
-    Event(EVENT_ID eventID, bool data)      : EventID(eventID) { Data.Bool = data; };
+    Event(EVENT_ID eventID, uint16_t data)  : EventID(eventID), Source(nullptr) { Data.UnsignedInt = data; };
 
-    Event(EVENT_ID eventID, float data)     : EventID(eventID) { Data.Float = data; };
+    Event(EVENT_ID eventID, bool data)      : EventID(eventID), Source(nullptr) { Data.Bool = data; };
 
-    Event(EVENT_ID eventID, void* pData)    : EventID(eventID) { Data.Pointer = pData; };
+    Event(EVENT_ID eventID, float data)     : EventID(eventID), Source(nullptr) { Data.Float = data; };
 
-    Event(EVENT_ID eventID, variant_t data) : EventID(eventID) { Data = data; };
+    Event(EVENT_ID eventID, void* pData)    : EventID(eventID), Source(nullptr) { Data.Pointer = pData; };
 
-    Event(EVENT_ID eventID, variant_union_t data) : EventID(eventID) { Data = data; };
+    Event(EVENT_ID eventID, variant_t data) : EventID(eventID), Source(nullptr) { Data = data; };
+
+    Event(EVENT_ID eventID, variant_union_t data) : EventID(eventID), Source(nullptr) { Data = data; };
 
     // Copy constructor
-    Event(const Event& rhs) : EventID(rhs.EventID), Source(rhs.Source), Data(rhs.Data) {  };
+    Event(const Event& rhs) : EventID(rhs.EventID), Data(rhs.Data), Source(rhs.Source) {  };
+#endif
+
+    /**************************************************************************
+    Source accessors (valid in both the full and compact profiles)
+    **************************************************************************/
+#if TASKSCHEDULER_COMPACT
+    EventSource* GetSource() const;     // Defined in EventSource.h
+
+    void SetSource(EventSource* pSource);
+#else
+    EventSource* GetSource() const { return Source; };
+
+    void SetSource(EventSource* pSource) { Source = pSource; };
+#endif
 
     /**************************************************************************
     Data
     **************************************************************************/
     EVENT_ID EventID;           // size = 2
-    variant_union_t Data;       // size = 4
+    event_data_t Data;          // size = 4 (compact = 2)
+#if TASKSCHEDULER_COMPACT
+    uint8_t SourceIndex;        // size = 1
+#else
     EventSource* Source;        // size = 2
+#endif
 };
 
+#if TASKSCHEDULER_COMPACT
+#if defined(__AVR__)
+static_assert(sizeof(Event) == 5, "Compact Event must be 5 bytes");
+#else
+static_assert(sizeof(Event) == 6, "Compact Event must be 5 bytes (6 with alignment padding)");
+#endif
+#endif
+
 #endif
@@ -0,0 +1,424 @@
+/*******************************************************************************
+Implementation file for the EventBridge, EventBridgeWriter and EventBridgeReader
+classes.
+*******************************************************************************/
+#define DEBUG 0
+
+#include <Arduino.h>
+#include <RTL_Stdlib.h>
+#include "EventBridge.h"
+#include "EventQueue.h"
+
+#if defined(__linux__)
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+
+static void PutUInt(uint8_t*& p, uint32_t value, uint8_t size)
+{
+    for (auto i = 0; i < size; i++, value >>= 8) *p++ = (uint8_t)value;
+}
+
+
+static uint32_t GetUInt(const uint8_t*& p, uint8_t size)
+{
+    uint32_t value = 0;
+
+    for (auto i = 0; i < size; i++) value |= (uint32_t)*p++ << (8 * i);
+
+    return value;
+}
+
+
+/*******************************************************************************
+EventBridge
+*******************************************************************************/
+
+uint8_t EventBridge::AddSource(EventSource& source)
+{
+    auto id = SourceId(&source);
+
+    if (id != 0 || _sourceCount >= EVENT_BRIDGE_SOURCES) return id;
+
+    _sources[_sourceCount++] = &source;
+
+    return _sourceCount;
+}
+
+
+uint8_t EventBridge::SourceId(const EventSource* pSource)
+{
+    for (uint8_t i = 0; i < _sourceCount; i++)
+    {
+        if (_sources[i] == pSource) return i + 1;
+    }
+
+    return 0;
+}
+
+
+uint16_t EventBridge::Checksum(uint8_t header, const uint8_t* pRecords, uint16_t length)
+{
+    uint16_t sum1 = header;
+    uint16_t sum2 = header;
+
+    for (uint16_t i = 0; i < length; i++)
+    {
+        sum1 = (sum1 + pRecords[i]) % 255;
+        sum2 = (sum2 + sum1) % 255;
+    }
+
+    return (sum2 << 8) | sum1;
+}
+
+
+/*******************************************************************************
+EventBridgeWriter
+*******************************************************************************/
+
+DEFINE_CLASSNAME(EventBridgeWriter);
+
+EventBridgeWriter* EventBridgeWriter::_pActive = nullptr;
+EventMonitorLink   EventBridgeWriter::_monitor(&EventBridgeWriter::Monitor);
+
+
+EventBridgeWriter::EventBridgeWriter(Print& output)
+    : _pOutput(&output), _count(0), _eventCount(0), _frameCount(0), _byteCount(0)
+{
+}
+
+
+void EventBridgeWriter::Begin()
+{
+    if (_pActive == this) return;
+
+    if (_pActive != nullptr) _pActive->End();
+
+    EventQueue::AddMonitor(_monitor);
+    _pActive = this;
+}
+
+
+void EventBridgeWriter::End()
+{
+    if (_pActive != this) return;
+
+    EventQueue::RemoveMonitor(_monitor);
+
+    _pActive = nullptr;
+
+    Flush();
+}
+
+
+//******************************************************************************
+// Forwards the events of the active writer's registered sources.
+//******************************************************************************
+void EventBridgeWriter::Monitor(const Event& event)
+{
+    auto pWriter = _pActive;
+
+    if (pWriter == nullptr) return;
+
+    auto id = pWriter->SourceId(event.GetSource());
+
+    if (id != 0) pWriter->Forward(event, id);
+}
+
+
+//******************************************************************************
+// Encodes an event into the frame buffer, writing the frame if it is full.
+//******************************************************************************
+void EventBridgeWriter::Forward(const Event& event, uint8_t sourceId)
+{
+    auto p = &_buffer[_count * RECORD_SIZE];
+
+    PutUInt(p, event.EventID, 2);
+#if TASKSCHEDULER_COMPACT
+    PutUInt(p, event.Data.UnsignedInt, DATA_SIZE);
+#else
+    PutUInt(p, event.Data.UnsignedLong, DATA_SIZE);
+#endif
+    *p = sourceId;
+
+    _eventCount++;
+
+    if (++_count >= EVENT_BRIDGE_BATCH)
+    {
+        Flush();
+    }
+    else if (_count == 1)
+    {
+        // Make sure the task runs promptly to write the partial batch
+#if TASKSCHEDULER_SIGNALS
+        Signal();
+#elif TASKSCHEDULER_BACKOFF
+        Wake();
+#endif
+    }
+}
+
+
+void EventBridgeWriter::Flush()
+{
+    if (_count == 0) return;
+
+    uint8_t  header = _count | (DATA_SIZE == 4 ? WIDE_DATA : 0);
+    uint16_t length = _count * RECORD_SIZE;
+    uint16_t checksum = Checksum(header, _buffer, length);
+    uint8_t  trailer[2] = { (uint8_t)checksum, (uint8_t)(checksum >> 8) };
+
+    _pOutput->write(SYNC);
+    _pOutput->write(header);
+    _pOutput->write(_buffer, length);
+    _pOutput->write(trailer, sizeof(trailer));
+
+    TRACE(Logger(_classname_, this) << F("Flush: events=") << _count << endl);
+
+    _byteCount += length + FRAME_OVERHEAD;
+    _frameCount++;
+    _count = 0;
+}
+
+
+bool EventBridgeWriter::PollWork()
+{
+    if (_count == 0) return false;
+
+    Flush();
+
+    return true;
+}
+
+
+/*******************************************************************************
+EventBridgeReader
+*******************************************************************************/
+
+DEFINE_CLASSNAME(EventBridgeReader);
+
+
+EventBridgeReader::EventBridgeReader(Stream& input)
+    : _pInput(&input), _state(Sync), _header(0), _length(0), _received(0), _checksum(0),
+      _eventCount(0), _frameCount(0), _errorCount(0)
+{
+}
+
+
+//******************************************************************************
+// Advances the frame decoder by one input byte.
+//******************************************************************************
+void EventBridgeReader::Receive(uint8_t b)
+{
+    switch (_state)
+    {
+        case Sync:
+            if (b == SYNC) _state = Header;
+            break;
+
+        case Header:
+        {
+            uint8_t count = b & ~WIDE_DATA;
+            uint8_t recordSize = 2 + ((b & WIDE_DATA) ? 4 : 2) + 1;
+
+            if (count == 0 || count > EVENT_BRIDGE_BATCH)
+            {
+                _errorCount++;
+                _state = (b == SYNC) ? Header : Sync;
+                break;
+            }
+
+            _header = b;
+            _length = count * recordSize;
+            _received = 0;
+            _state = Records;
+            break;
+        }
+
+        case Records:
+            _buffer[_received++] = b;
+            if (_received == _length) _state = ChecksumLow;
+            break;
+
+        case ChecksumLow:
+            _checksum = b;
+            _state = ChecksumHigh;
+            break;
+
+        case ChecksumHigh:
+            _checksum |= (uint16_t)b << 8;
+
+            if (_checksum == Checksum(_header, _buffer, _length))
+            {
+                _frameCount++;
+                _received = 0;
+                _state = Queuing;
+            }
+            else
+            {
+                TRACE(Logger(_classname_, this) << F("Receive: bad checksum") << endl);
+                _errorCount++;
+                _state = Sync;
+            }
+            break;
+
+        case Queuing:
+            break;
+    }
+}
+
+
+//******************************************************************************
+// Queues the received frame's events, resuming where the last call left off.
+//******************************************************************************
+bool EventBridgeReader::QueueRecords()
+{
+    uint8_t dataSize = (_header & WIDE_DATA) ? 4 : 2;
+    uint8_t recordSize = 2 + dataSize + 1;
+
+    while (_received < _length)
+    {
+        const uint8_t* p = &_buffer[_received];
+
+        auto eventID = (EVENT_ID)GetUInt(p, 2);
+        auto data = GetUInt(p, dataSize);
+        auto pSource = SourceFromId(*p);
+
+        if (dataSize == 2) data = (uint32_t)(int32_t)(int16_t)data;
+
+        Event event(eventID, data);
+        event.SetSource(pSource != nullptr ? pSource : this);
+
+        // The queue is full (possibly filled by an ISR); retry this record later
+        if (!EventQueue::Queue(event)) return false;
+
+        _received += recordSize;
+        _eventCount++;
+    }
+
+    _state = Sync;
+
+    return true;
+}
+
+
+bool EventBridgeReader::PollWork()
+{
+    auto didWork = false;
+
+    if (_state == Queuing)
+    {
+        if (!QueueRecords()) return true;
+
+        didWork = true;
+    }
+
+    while (_pInput->available() > 0)
+    {
+        auto b = _pInput->read();
+
+        if (b < 0) break;
+
+        Receive((uint8_t)b);
+        didWork = true;
+
+        // Hold off reading further input until the frame has been queued
+        if (_state == Queuing && !QueueRecords()) break;
+    }
+
+    return didWork;
+}
+
+
+#if defined(__linux__)
+/*******************************************************************************
+FileDescriptorStream
+*******************************************************************************/
+
+FileDescriptorStream::FileDescriptorStream(int fd) : _fd(fd), _head(0), _tail(0)
+{
+    auto flags = fcntl(fd, F_GETFL);
+
+    _isNonBlocking = flags >= 0 && (flags & O_NONBLOCK) != 0;
+}
+
+
+//******************************************************************************
+// Refills the read buffer once it has been drained, with a single read(). A
+// blocking descriptor is checked for pending input first so the read cannot
+// block.
+//******************************************************************************
+bool FileDescriptorStream::Fill()
+{
+    if (_head < _tail) return true;
+
+    if (!_isNonBlocking)
+    {
+        int pending = 0;
+
+        if (ioctl(_fd, FIONREAD, &pending) < 0 || pending <= 0) return false;
+    }
+
+    auto n = ::read(_fd, _buffer, sizeof(_buffer));
+
+    if (n <= 0) return false;
+
+    _head = 0;
+    _tail = (uint16_t)n;
+
+    return true;
+}
+
+
+//******************************************************************************
+// Returns the number of buffered bytes, refilling the buffer when it is empty.
+// The count does not include input still waiting in the descriptor.
+//******************************************************************************
+int FileDescriptorStream::available()
+{
+    return Fill() ? _tail - _head : 0;
+}
+
+
+int FileDescriptorStream::read()
+{
+    return Fill() ? _buffer[_head++] : -1;
+}
+
+
+int FileDescriptorStream::peek()
+{
+    return Fill() ? _buffer[_head] : -1;
+}
+
+
+size_t FileDescriptorStream::write(const uint8_t* pBuffer, size_t size)
+{
+    size_t written = 0;
+
+    while (written < size)
+    {
+        auto n = ::write(_fd, pBuffer + written, size - written);
+
+        if (n > 0)
+        {
+            written += n;
+        }
+        else if (n < 0 && errno == EAGAIN)
+        {
+            pollfd pfd = { _fd, POLLOUT, 0 };
+            ::poll(&pfd, 1, -1);
+        }
+        else if (n < 0 && errno != EINTR)
+        {
+            break;
+        }
+    }
+
+    return written;
+}
+#endif
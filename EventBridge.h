@@ -0,0 +1,280 @@
+#pragma once
+/*******************************************************************************
+Header file for the EventBridge, EventBridgeWriter and EventBridgeReader
+classes.
+*******************************************************************************/
+
+#include <RTL_StdLib.h>
+#include "TaskSchedulerConfig.h"
+#include "Event.h"
+#include "EventQueue.h"
+#include "EventSource.h"
+#include "TaskBase.h"
+
+
+//******************************************************************************
+/// The common part of the two ends of an event bridge: the wire format and the
+/// table of sources that are identified on the wire.
+///
+/// An event bridge forwards events to another processor (e.g., a companion
+/// computer) over any Stream, such as a UART, in a framed binary format:
+///
+///     Frame:  0xA5, header (1 byte), records, checksum (2 bytes)
+///     Header: bit 7 = 32 bit data, bits 0-6 = number of records (1..127)
+///     Record: EventID (2 bytes), Data (2 or 4 bytes), source id (1 byte)
+///
+/// Multi-byte values are little-endian. The checksum is a Fletcher-16 sum of
+/// the header and the records. The compact profile sends 16 bit data (5 bytes
+/// per event), the full profile 32 bit data (7 bytes per event). A compact
+/// receiver keeps the low 16 bits of 32 bit data, and a full receiver sign
+/// extends 16 bit data.
+///
+/// Each end registers the sources it identifies on the wire with AddSource().
+/// Ids are assigned in registration order starting at 1, so both ends must
+/// register corresponding sources in the same order. Id 0 means "no source".
+//******************************************************************************
+class EventBridge
+{
+    /*--------------------------------------------------------------------------
+    Constants
+    --------------------------------------------------------------------------*/
+    public: static const uint8_t SYNC = 0xA5;
+
+    public: static const uint8_t WIDE_DATA = 0x80;
+
+#if TASKSCHEDULER_COMPACT
+    public: static const uint8_t DATA_SIZE = 2;
+#else
+    public: static const uint8_t DATA_SIZE = 4;
+#endif
+
+    /// The number of bytes in a record with this profile's data size
+    public: static const uint8_t RECORD_SIZE = 2 + DATA_SIZE + 1;
+
+    /// The number of bytes in a frame in addition to its records
+    public: static const uint8_t FRAME_OVERHEAD = 4;
+
+    /*--------------------------------------------------------------------------
+    Constructors
+    --------------------------------------------------------------------------*/
+    protected: EventBridge() : _sourceCount(0) { };
+
+    /*--------------------------------------------------------------------------
+    Public interface
+    --------------------------------------------------------------------------*/
+    //**************************************************************************
+    /// Registers a source and returns its id, or 0 if the table is full.
+    //**************************************************************************
+    public: uint8_t AddSource(EventSource& source);
+
+    //**************************************************************************
+    /// Returns the id of a registered source, or 0 if it is not registered.
+    //**************************************************************************
+    public: uint8_t SourceId(const EventSource* pSource);
+
+    //**************************************************************************
+    /// Returns the source registered with an id, or nullptr.
+    //**************************************************************************
+    public: EventSource* SourceFromId(uint8_t id)
+    {
+        return (id > 0 && id <= _sourceCount) ? _sources[id - 1] : nullptr;
+    };
+
+    /*--------------------------------------------------------------------------
+    Internal implementation
+    --------------------------------------------------------------------------*/
+    /// Computes the Fletcher-16 checksum of a frame's header and records
+    protected: static uint16_t Checksum(uint8_t header, const uint8_t* pRecords, uint16_t length);
+
+    private: EventSource* _sources[EVENT_BRIDGE_SOURCES];
+    private: uint8_t      _sourceCount;
+};
+
+
+//******************************************************************************
+/// The sending end of an event bridge.
+///
+/// Between Begin() and End() the writer is one of the EventQueue's monitors
+/// (like the EventRecorder), so every event from a source registered with
+/// AddSource() is forwarded as it is dequeued, whether TaskManager::Dispatch()
+/// or EventQueue::Dispatch() delivers it. Events that a source dispatches
+/// directly with DispatchEvent() never pass through the queue and are not
+/// forwarded. Only one writer can be forwarding at a time.
+///
+/// Events are encoded into a frame buffer and written as a single frame when
+/// the batch is full or when the writer task runs, so include the writer in
+/// the task list. Forwarding an event only costs a few byte copies; nothing is
+/// formatted.
+///
+/// Writing a frame blocks if the output's transmit buffer is full. Size
+/// EVENT_BRIDGE_BATCH and the baud rate for the expected event rate (see the
+/// EventBridgeBenchmark example).
+//******************************************************************************
+class EventBridgeWriter : public EventBridge, public TaskBase
+{
+    DECLARE_CLASSNAME;
+
+    /*--------------------------------------------------------------------------
+    Constructors
+    --------------------------------------------------------------------------*/
+    public: EventBridgeWriter(Print& output);
+
+    public: ~EventBridgeWriter() { End(); };
+
+    /*--------------------------------------------------------------------------
+    Public interface
+    --------------------------------------------------------------------------*/
+    //**************************************************************************
+    /// Starts forwarding the events of the registered sources. Any writer that
+    /// is already forwarding is stopped first.
+    //**************************************************************************
+    public: void Begin();
+
+    //**************************************************************************
+    /// Stops forwarding and writes any buffered events.
+    //**************************************************************************
+    public: void End();
+
+    //**************************************************************************
+    /// Writes any buffered events as a frame.
+    //**************************************************************************
+    public: void Flush();
+
+    //**************************************************************************
+    /// Statistics for benchmarking: events forwarded, frames written, and
+    /// total bytes written.
+    //**************************************************************************
+    public: uint32_t EventCount() { return _eventCount; };
+    public: uint32_t FrameCount() { return _frameCount; };
+    public: uint32_t ByteCount() { return _byteCount; };
+
+    /*--------------------------------------------------------------------------
+    Overrides
+    --------------------------------------------------------------------------*/
+    public: bool PollWork() override;
+
+    public: const __FlashStringHelper* Name() override { return F("EventBridgeWriter"); };
+
+    /*--------------------------------------------------------------------------
+    Internal implementation
+    --------------------------------------------------------------------------*/
+    /// EventQueue monitor that forwards an event through the active writer
+    private: static void Monitor(const Event& event);
+
+    /// Encodes an event into the frame buffer
+    private: void Forward(const Event& event, uint8_t sourceId);
+
+    /// The writer that is forwarding, and its link in the monitor chain
+    private: static EventBridgeWriter* _pActive;
+    private: static EventMonitorLink   _monitor;
+
+    private: Print*   _pOutput;
+    private: uint8_t  _buffer[EVENT_BRIDGE_BATCH * RECORD_SIZE];
+    private: uint8_t  _count;               // Events in the buffer
+    private: uint32_t _eventCount;
+    private: uint32_t _frameCount;
+    private: uint32_t _byteCount;
+};
+
+
+//******************************************************************************
+/// The receiving end of an event bridge.
+///
+/// The reader task decodes frames from its input and queues their events to
+/// the EventQueue, where they are dispatched like locally queued events: to the
+/// current state by TaskManager::Dispatch(), or to the listeners of their
+/// source by EventQueue::Dispatch(). An event's source is the source registered
+/// with the matching id, or the reader itself if no source is registered with
+/// that id.
+///
+/// Frames with a bad checksum or an invalid header are discarded and the
+/// reader resynchronizes on the next 0xA5 byte. When the EventQueue is full the
+/// remainder of the frame is queued on later passes and no further input is
+/// read until then, so the sender is throttled by its output buffer instead of
+/// events being lost.
+//******************************************************************************
+class EventBridgeReader : public EventBridge, public TaskBase, public EventSource
+{
+    DECLARE_CLASSNAME;
+
+    /*--------------------------------------------------------------------------
+    Constructors
+    --------------------------------------------------------------------------*/
+    public: EventBridgeReader(Stream& input);
+
+    /*--------------------------------------------------------------------------
+    Public interface
+    --------------------------------------------------------------------------*/
+    //**************************************************************************
+    /// Statistics: events queued, frames received, and frames discarded.
+    //**************************************************************************
+    public: uint32_t EventCount() { return _eventCount; };
+    public: uint32_t FrameCount() { return _frameCount; };
+    public: uint32_t ErrorCount() { return _errorCount; };
+
+    /*--------------------------------------------------------------------------
+    Overrides
+    --------------------------------------------------------------------------*/
+    public: bool PollWork() override;
+
+    public: const __FlashStringHelper* Name() override { return F("EventBridgeReader"); };
+
+    /*--------------------------------------------------------------------------
+    Internal implementation
+    --------------------------------------------------------------------------*/
+    private: enum ReadState : uint8_t { Sync, Header, Records, ChecksumLow, ChecksumHigh, Queuing };
+
+    /// Consumes one input byte
+    private: void Receive(uint8_t b);
+
+    /// Queues the received frame's events until the EventQueue is full.
+    /// Returns true when the whole frame has been queued.
+    private: bool QueueRecords();
+
+    private: Stream*   _pInput;
+    private: uint8_t   _buffer[EVENT_BRIDGE_BATCH * (2 + 4 + 1)];
+    private: ReadState _state;
+    private: uint8_t   _header;
+    private: uint16_t  _length;             // Bytes of records in the frame
+    private: uint16_t  _received;           // Bytes of records received, or queued
+    private: uint16_t  _checksum;
+    private: uint32_t  _eventCount;
+    private: uint32_t  _frameCount;
+    private: uint32_t  _errorCount;
+};
+
+
+#if defined(__linux__)
+//******************************************************************************
+/// A Stream over a Linux file descriptor (a pipe, pty, socket, or serial
+/// device), for running an event bridge on the host. Reads never block; writes
+/// block until all bytes are written. The descriptor is not closed by the
+/// stream.
+///
+/// Input is read into a buffer with one read() whenever the buffer is empty,
+/// and available() and read() serve buffered bytes without a system call. If
+/// the descriptor is blocking, each refill first checks for pending input with
+/// an ioctl; open it with O_NONBLOCK to save that call.
+//******************************************************************************
+class FileDescriptorStream : public Stream
+{
+    public: FileDescriptorStream(int fd);
+
+    public: int available() override;
+    public: int read() override;
+    public: int peek() override;
+    public: size_t write(uint8_t b) override { return write(&b, 1); };
+    public: size_t write(const uint8_t* pBuffer, size_t size) override;
+
+    /// Reads whatever input is available into the read buffer if it is empty
+    private: bool Fill();
+
+    private: int      _fd;
+    private: bool     _isNonBlocking;       // Reads return EAGAIN rather than block
+    private: uint8_t  _buffer[256];         // Read buffer
+    private: uint16_t _head;
+    private: uint16_t _tail;
+};
+#endif
+
+static_assert(EVENT_BRIDGE_BATCH > 0 && EVENT_BRIDGE_BATCH <= 127, "EVENT_BRIDGE_BATCH must be between 1 and 127");
@@ -20,6 +20,8 @@ class EventSourceID
         Navigation             = 0x0C00,
         Task                   = 0x0D00,
         Keypad                 = 0x0E00,
+        FileDescriptor         = 0x0F00,
+        Topic                  = 0x1000,
         CustomEvent            = 0xF000
     };
 };
@@ -56,6 +58,21 @@ class EventCode
         KeyPressed     = 0x0019,    // A key was pressed on a keypad
         SpinAbort      = 0x001A,    // Aborted a spin movement
         TurnAbort      = 0x001B,    // Aborted a turn movement
+        Readable       = 0x001C,    // A file descriptor is ready for reading
+        Writable       = 0x001D,    // A file descriptor is ready for writing
+        Closed         = 0x001E,    // A file descriptor was hung up or has an error
+    };
+};
+
+
+class EventPriority
+{
+    public: enum
+    {
+        Low            = 0,         // Diagnostics and other deferrable events
+        Normal         = 1,         // Routine events
+        High           = 2,         // Events that need prompt attention (obstacles, aborts)
+        Critical       = 3,         // Reserved for events queued with an explicit priority
     };
 };
 
@@ -68,6 +85,10 @@ enum CommonEvents_enum
     TaskCompleteEvent = EventSourceID::Task       | EventCode::Complete,
     TaskAbortedEvent  = EventSourceID::Task       | EventCode::Aborted,
     TaskResponseEvent = EventSourceID::Task       | EventCode::Response,
+    FileReadableEvent = EventSourceID::FileDescriptor | EventCode::Readable,
+    FileWritableEvent = EventSourceID::FileDescriptor | EventCode::Writable,
+    FileClosedEvent   = EventSourceID::FileDescriptor | EventCode::Closed,
+    TopicUpdatedEvent = EventSourceID::Topic      | EventCode::Update,
 };
 
 #endif
@@ -3,6 +3,7 @@
 #include <Arduino.h>
 #include "EventSource.h"
 #include "EventQueue.h"
+#include "EventCodes.h"
 
 
 /*******************************************************************************
@@ -16,20 +17,65 @@ sketch's loop() method. The Dispatch() will dispatch all events that had been
 queued up to the point it was called. It does not dispatch any new events triggered
 as a result of processing disptached events. Those events will be dispatched on
 the next go-around.
+
+Events are delivered highest priority first, among the events that were queued
+when the pass began (see EventQueue::Snapshot). Queue slots are allocated from a
+free list, and each priority level is a FIFO list of slots linked through the
+_link array. Links hold slot index + 1 so that zero-initialized statics are
+empty lists.
 *******************************************************************************/
 
 DEFINE_CLASSNAME(EventQueue);
 
 Event   EventQueue::_queue[QUEUE_SIZE];
-uint8_t EventQueue::_queueHead = 0;
-uint8_t EventQueue::_queueTail = 0;
+uint8_t EventQueue::_link[QUEUE_SIZE];
+uint8_t EventQueue::_head[LEVELS];
+uint8_t EventQueue::_tail[LEVELS];
+uint8_t EventQueue::_levelCount[LEVELS];
+uint8_t EventQueue::_free = 0;
+uint8_t EventQueue::_unused = 0;
 int8_t  EventQueue::_queueCount = 0;
+EventMonitorLink* EventQueue::_pMonitors = nullptr;
+EVENT_PRIORITY_MAP EventQueue::_pfPriorityMap = &EventQueue::DefaultPriority;
+
+
+//******************************************************************************
+// Derives a priority from the event code portion of an event ID
+//******************************************************************************
+uint8_t EventQueue::DefaultPriority(EVENT_ID eventID)
+{
+    switch (eventID & 0x00FF)
+    {
+        case EventCode::Obstacle:
+        case EventCode::Aborted:
+        case EventCode::SpinAbort:
+        case EventCode::TurnAbort:
+            return EventPriority::High;
+
+        case EventCode::DebugInfo:
+            return EventPriority::Low;
+
+        default:
+            return EventPriority::Normal;
+    }
+}
 
 
 //******************************************************************************
 // Queues an event to the event queue
 //******************************************************************************
 bool EventQueue::Queue(EventSource& eventSource, EVENT_ID eventID, variant_t eventData)
+{
+    Event event(eventID, eventData); { event.SetSource(&eventSource); }
+
+    return Queue(event);
+}
+
+
+//******************************************************************************
+// Queues a copy of an event to the event queue with the given priority
+//******************************************************************************
+bool EventQueue::Queue(Event& event, uint8_t priority)
 {
     /*
     Interrupts MUST be disabled while an event is being queued to ensure stability
@@ -56,21 +102,52 @@ bool EventQueue::Queue(EventSource& eventSource, EVENT_ID eventID, variant_t eve
 
     auto isQueued = false;
 
+    if (priority >= LEVELS) priority = LEVELS - 1;
+
     noInterrupts(); // ATOMIC BLOCK BEGIN
 
-    if (_queueCount <= QUEUE_SIZE)
+    if (_queueCount < QUEUE_SIZE)
     {
-        _queue[_queueTail].Source  = &eventSource;
-        _queue[_queueTail].EventID = eventID;
-        _queue[_queueTail].Data    = eventData;
-        _queueTail = (_queueTail + 1) % QUEUE_SIZE;
+        // Take a slot from the free list, or one that has never been used
+        uint8_t slot;
+
+        if (_free != 0)
+        {
+            slot = _free - 1;
+            _free = _link[slot];
+        }
+        else
+        {
+            slot = _unused++;
+        }
+
+        _queue[slot] = event;
+        _link[slot] = 0;
+
+        // Append the slot to its priority list
+        if (_tail[priority] != 0) _link[_tail[priority] - 1] = slot + 1;
+        else _head[priority] = slot + 1;
+
+        _tail[priority] = slot + 1;
+        _levelCount[priority]++;
         _queueCount++;
         isQueued = true;
     }
 
     interrupts(); // ATOMIC BLOCK END
 
-    return isQueued;
+    if (!isQueued) return false;
+
+    // A monitor may remove itself, so take the next link first
+    for (auto pLink = _pMonitors; pLink != nullptr; )
+    {
+        auto pNext = pLink->_pNext;
+
+        if (pLink->_pfArrival != nullptr) (*pLink->_pfArrival)(event, priority);
+        pLink = pNext;
+    }
+
+    return true;
 }
 
 
@@ -83,7 +160,7 @@ bool EventQueue::Dequeue(Event& event)
     stability while the queue is being manipulated. HOWEVER, disabling interrupts
     MUST come AFTER the queue-empty check.
 
-    There is no harm if the queue-empty check (_queueHead == _queueTail) produces 
+    There is no harm if the queue-empty check (_queueCount == 0) produces 
     an "incorrect" TRUE response while an asynchronous interrupt queues. It will 
     just pick up that event the next time Dequeue() is called.
 
@@ -98,17 +175,118 @@ bool EventQueue::Dequeue(Event& event)
     */
 
     // Check for empty queue
-    if (_queueHead == _queueTail) return false;
+    if (_queueCount == 0) return false;
 
     noInterrupts(); // ATOMIC BLOCK BEGIN
 
-    event = _queue[_queueHead];
-    _queueHead = (_queueHead + 1) % QUEUE_SIZE;
+    // Take the first slot of the highest priority non-empty list
+    auto priority = LEVELS - 1;
+
+    while (_head[priority] == 0 && priority > 0) priority--;
+
+    Remove(event, priority);
+
+    return true;
+}
+
+
+void EventQueue::TakeSnapshot(Snapshot& snapshot)
+{
+    noInterrupts(); // ATOMIC BLOCK BEGIN
+
+    for (uint8_t i = 0; i < LEVELS; i++) snapshot.Pending[i] = _levelCount[i];
+
+    interrupts();   // ATOMIC BLOCK END
+}
+
+
+//******************************************************************************
+// Dequeues the first event of the highest priority that still has events
+// pending in the snapshot. Since each priority list is FIFO and ISRs only
+// append, these are the events that were queued before the snapshot.
+//******************************************************************************
+bool EventQueue::Dequeue(Event& event, Snapshot& snapshot)
+{
+    for (auto priority = LEVELS; priority-- > 0; )
+    {
+        if (snapshot.Pending[priority] == 0) continue;
+
+        snapshot.Pending[priority]--;
+
+        noInterrupts(); // ATOMIC BLOCK BEGIN
+
+        // The event may already have been dequeued by someone else
+        if (_head[priority] == 0)
+        {
+            interrupts();   // ATOMIC BLOCK END
+            continue;
+        }
+
+        Remove(event, priority);
+
+        return true;
+    }
+
+    return false;
+}
+
+
+//******************************************************************************
+// Called with interrupts disabled; enables them before notifying the monitors
+//******************************************************************************
+void EventQueue::Remove(Event& event, uint8_t priority)
+{
+    uint8_t slot = _head[priority] - 1;
+
+    event = _queue[slot];
+
+    _head[priority] = _link[slot];
+    if (_head[priority] == 0) _tail[priority] = 0;
+
+    // Return the slot to the free list
+    _link[slot] = _free;
+    _free = slot + 1;
+    _levelCount[priority]--;
     _queueCount--;
 
     interrupts();   // ATOMIC BLOCK END
 
-    return true;
+    // A monitor may remove itself, so take the next link first
+    for (auto pLink = _pMonitors; pLink != nullptr; )
+    {
+        auto pNext = pLink->_pNext;
+
+        if (pLink->_pfMonitor != nullptr) (*pLink->_pfMonitor)(event);
+        pLink = pNext;
+    }
+}
+
+
+void EventQueue::AddMonitor(EventMonitorLink& link)
+{
+    auto ppLink = &_pMonitors;
+
+    for (; *ppLink != nullptr; ppLink = &(*ppLink)->_pNext)
+    {
+        if (*ppLink == &link) return;
+    }
+
+    link._pNext = nullptr;
+    *ppLink = &link;
+}
+
+
+void EventQueue::RemoveMonitor(EventMonitorLink& link)
+{
+    for (auto ppLink = &_pMonitors; *ppLink != nullptr; ppLink = &(*ppLink)->_pNext)
+    {
+        if (*ppLink == &link)
+        {
+            *ppLink = link._pNext;
+            link._pNext = nullptr;
+            return;
+        }
+    }
 }
 
 
@@ -117,18 +295,21 @@ void EventQueue::Dispatch()
     // Dispatch all events that were queued up to this point.
     // NOTE: This loop is specifically constructed to only go around the event queue
     // at most one time. It does NOT dispatch any new events added as a result of
-    // processing a dispatched event. Those will get processed on the next go-around. 
-    // Otherwise, we could create an endless loop where object A posts an event 
-    // that object B receives who, in turn, posts an event that object A receives, 
-    // etc... In such a scenario the event queue would never empty and the dispatch 
-    // loop would go on forever.
-    for (auto i = _queueCount; i > 0; i--)
+    // processing a dispatched event, whatever their priority. Those will get
+    // processed on the next go-around. Otherwise, we could create an endless loop
+    // where object A posts an event that object B receives who, in turn, posts an
+    // event that object A receives, etc... In such a scenario the event queue would
+    // never empty and the dispatch loop would go on forever.
+    Snapshot snapshot;
+    Event event;
+
+    TakeSnapshot(snapshot);
+
+    while (Dequeue(event, snapshot))
     {
-        Event event;
+        auto pSource = event.GetSource();
 
-        if (Dequeue(event))
-        {
-            if (event.Source != nullptr) event.Source->DispatchEvent(event);
-        }
+        // The event was throttled when it was queued
+        if (pSource != nullptr) pSource->DeliverEvent(event);
     }
 }
@@ -2,20 +2,65 @@
 #define _EventQueue_h_
 
 #include <RTL_StdLib.h>
+#include "TaskSchedulerConfig.h"
 #include "Event.h"
 
 
+/// Signature of a function that observes every event dequeued from the EventQueue.
+typedef void (*EVENT_MONITOR)(const Event& event);
+
+/// Signature of a function that observes every event queued to the EventQueue,
+/// with the priority it was queued at.
+typedef void (*EVENT_ARRIVAL_MONITOR)(const Event& event, uint8_t priority);
+
+/// Signature of a function that assigns a priority to an event ID.
+typedef uint8_t (*EVENT_PRIORITY_MAP)(EVENT_ID eventID);
+
+
+//******************************************************************************
+/// A link in the EventQueue's chain of monitors. Each monitor (e.g., the
+/// EventRecorder) owns a link for its function and adds it to the chain with
+/// EventQueue::AddMonitor(). A link observes either dequeued events (an
+/// EVENT_MONITOR) or queued events (an EVENT_ARRIVAL_MONITOR).
+//******************************************************************************
+class EventMonitorLink
+{
+    friend class EventQueue;
+
+    public: constexpr EventMonitorLink(EVENT_MONITOR pfMonitor) : _pfMonitor(pfMonitor), _pfArrival(nullptr), _pNext(nullptr) { };
+
+    public: constexpr EventMonitorLink(EVENT_ARRIVAL_MONITOR pfArrival) : _pfMonitor(nullptr), _pfArrival(pfArrival), _pNext(nullptr) { };
+
+    private: EVENT_MONITOR         _pfMonitor;
+    private: EVENT_ARRIVAL_MONITOR _pfArrival;
+    private: EventMonitorLink*     _pNext;
+};
+
+
 /*******************************************************************************
 Event queue manager.
 
 EventQueue is a global static singleton that queues and dispatches events in a
 program.
+
+Each queued event has a priority (see EventPriority), either given when it is
+queued or derived from its EVENT_ID. Events are dequeued highest priority first
+and in FIFO order within a priority. The queue slots are shared by all
+priorities: each priority is a linked list of slot indexes, so queueing and
+dequeueing are O(1) and take the same number of slots as a plain FIFO.
+
+A dispatch pass takes a Snapshot of the number of events queued at each
+priority and then dequeues only those events. Events queued during the pass,
+even urgent ones, wait for the next pass, and every event queued before the
+pass is delivered in it, so a steady stream of High events cannot starve Low
+ones for more than one pass.
 *******************************************************************************/
 class EventQueue
 {
     DECLARE_CLASSNAME;
 
-    private: static const int QUEUE_SIZE = 8;
+    private: static const int QUEUE_SIZE = EVENT_QUEUE_SIZE;
+    private: static const uint8_t LEVELS = EVENT_PRIORITY_LEVELS;
 
     // The singleton instance
     //public: static EventQueue SoleInstance;
@@ -27,26 +72,83 @@ class EventQueue
     /*--------------------------------------------------------------------------
     Public interface
     --------------------------------------------------------------------------*/
-    public: static bool Queue(Event& event) { return Queue(*event.Source, event.EventID, event.Data);  };
+    public: static bool Queue(Event& event) { return Queue(event, PriorityOf(event.EventID)); };
+
+    public: static bool Queue(Event& event, uint8_t priority);
 
     public: static bool Queue(EventSource& source, EVENT_ID eventID, variant_t eventData = 0L);
 
     public: static bool Dequeue(Event& event);
 
+    /// The number of events queued at each priority at the start of a pass
+    public: struct Snapshot
+    {
+        uint8_t Pending[EVENT_PRIORITY_LEVELS];
+    };
+
+    /// Records the events queued so far, for Dequeue(Event&, Snapshot&)
+    public: static void TakeSnapshot(Snapshot& snapshot);
+
+    /// Dequeues the highest priority event recorded in the snapshot. Returns
+    /// false once all of the recorded events have been dequeued.
+    public: static bool Dequeue(Event& event, Snapshot& snapshot);
+
     public: static void Dispatch();
 
     public: static int8_t Length() { return _queueCount; };
 
+    public: static int8_t Capacity() { return QUEUE_SIZE; };
+
+    /// Sets the function that derives an event's priority from its EVENT_ID
+    /// when no priority is given. Passing nullptr restores DefaultPriority().
+    public: static void SetPriorityMap(EVENT_PRIORITY_MAP pfMap) { _pfPriorityMap = (pfMap != nullptr) ? pfMap : &DefaultPriority; };
+
+    /// Returns the priority assigned to an event ID by the current priority map
+    public: static uint8_t PriorityOf(EVENT_ID eventID) { return (*_pfPriorityMap)(eventID); };
+
+    /// The default priority map: aborts and obstacles are High, DebugInfo is
+    /// Low and everything else is Normal.
+    public: static uint8_t DefaultPriority(EVENT_ID eventID);
+
+    /// Adds a monitor that observes every event as it is dequeued (e.g., the
+    /// SharedEventRing) or, for an arrival monitor, as it is queued (e.g., the
+    /// EventRecorder). Monitors are called in the order they were added, and
+    /// can be added and removed in any order. Adding a link that is already in
+    /// the chain has no effect. An arrival monitor is called by Queue() after
+    /// the event has been queued, so it runs in an ISR if the event was queued
+    /// by one.
+    public: static void AddMonitor(EventMonitorLink& link);
+
+    /// Removes a monitor from the chain. Has no effect if it is not in it.
+    public: static void RemoveMonitor(EventMonitorLink& link);
+
     /*--------------------------------------------------------------------------
     Internal implementation
     --------------------------------------------------------------------------*/
+    /// Removes the first event of a non-empty priority list and notifies the
+    /// monitor
+    private: static void Remove(Event& event, uint8_t priority);
+
     /// The event queue 
-    private: static Event _queue[QUEUE_SIZE];   // size = sizeof(Event)*QUEUE_SIZE = 8*8 = 64 bytes
+    private: static Event _queue[QUEUE_SIZE];   // size = sizeof(Event)*QUEUE_SIZE = 8*8 = 64 bytes (compact = 5*8 = 40 bytes)
 
-    /// The event queue head and tail pointers
-    private: static uint8_t _queueHead;         // size = 1
-    private: static uint8_t _queueTail;         // size = 1
+    /// Slot links (index + 1, 0 = none) for the per-priority lists and the free list
+    private: static uint8_t _link[QUEUE_SIZE];  // size = QUEUE_SIZE
+    private: static uint8_t _head[LEVELS];      // size = LEVELS
+    private: static uint8_t _tail[LEVELS];      // size = LEVELS
+    private: static uint8_t _levelCount[LEVELS];// size = LEVELS
+    private: static uint8_t _free;              // size = 1
+    private: static uint8_t _unused;            // size = 1 (slots never used yet start here)
     private: static int8_t  _queueCount;        // size = 1
+
+    /// Derives an event's priority from its ID
+    private: static EVENT_PRIORITY_MAP _pfPriorityMap;
+
+    /// The chain of event monitors (or nullptr)
+    private: static EventMonitorLink* _pMonitors;   // size = 2
 };
 
+static_assert(EVENT_QUEUE_SIZE > 0 && EVENT_QUEUE_SIZE <= 127, "EVENT_QUEUE_SIZE must be between 1 and 127");
+static_assert(EVENT_PRIORITY_LEVELS > 0 && EVENT_PRIORITY_LEVELS <= 4, "EVENT_PRIORITY_LEVELS must be between 1 and 4");
+
 #endif
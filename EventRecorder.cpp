@@ -0,0 +1,278 @@
+/*******************************************************************************
+Implementation file for the EventRecorder and EventReplayer classes.
+*******************************************************************************/
+#define DEBUG 0
+
+#include <Arduino.h>
+#include <RTL_Stdlib.h>
+#include "EventQueue.h"
+#include "EventRecorder.h"
+#include "RTL_TaskManager.h"
+#include "TaskClock.h"
+
+
+static const uint8_t LOG_MAGIC[] = { 'R', 'T', 'L', 'E' };
+
+
+static void WriteUInt(Print& out, uint32_t value, uint8_t size)
+{
+    for (auto i = 0; i < size; i++, value >>= 8) out.write((uint8_t)value);
+}
+
+
+static void WriteVarint(Print& out, uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        out.write((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+
+    out.write((uint8_t)value);
+}
+
+
+/*******************************************************************************
+EventRecorder
+*******************************************************************************/
+
+DEFINE_CLASSNAME(EventRecorder);
+
+Print*       EventRecorder::_pLog = nullptr;
+uint32_t     EventRecorder::_lastTime = 0;
+uint32_t     EventRecorder::_recordCount = 0;
+EventMonitorLink EventRecorder::_monitor(&EventRecorder::Record);
+EventSource* EventRecorder::_sources[EVENT_SOURCE_MAX];
+uint8_t      EventRecorder::_sourceCount = 0;
+
+
+uint8_t EventRecorder::AddSource(EventSource& source)
+{
+    auto id = SourceId(&source);
+
+    if (id != 0 || _sourceCount >= EVENT_SOURCE_MAX) return id;
+
+    _sources[_sourceCount++] = &source;
+
+    return _sourceCount;
+}
+
+
+uint8_t EventRecorder::SourceId(const EventSource* pSource)
+{
+    for (uint8_t i = 0; i < _sourceCount; i++)
+    {
+        if (_sources[i] == pSource) return i + 1;
+    }
+
+    return 0;
+}
+
+
+EventSource* EventRecorder::SourceFromId(uint8_t id)
+{
+    return (id > 0 && id <= _sourceCount) ? _sources[id - 1] : nullptr;
+}
+
+
+void EventRecorder::Begin(Print& log)
+{
+    EventQueue::AddMonitor(_monitor);
+
+    _pLog = &log;
+    _lastTime = TaskClock::Millis();
+    _recordCount = 0;
+
+    log.write(LOG_MAGIC, sizeof(LOG_MAGIC));
+    log.write(FORMAT_VERSION);
+    WriteUInt(log, _lastTime, 4);
+
+    TRACE(Logger(_classname_) << F("Begin: time=") << _lastTime << endl);
+}
+
+
+void EventRecorder::End()
+{
+    if (_pLog == nullptr) return;
+
+    EventQueue::RemoveMonitor(_monitor);
+
+    _pLog->flush();
+    _pLog = nullptr;
+}
+
+
+//******************************************************************************
+// Writes a record for an event queued by a registered input source.
+//******************************************************************************
+void EventRecorder::Record(const Event& event, uint8_t priority)
+{
+    auto id = SourceId(event.GetSource());
+
+    if (id == 0 || _pLog == nullptr) return;
+
+    auto now = TaskClock::Millis();
+
+    WriteVarint(*_pLog, now - _lastTime);
+    WriteUInt(*_pLog, event.EventID, 2);
+#if TASKSCHEDULER_COMPACT
+    WriteUInt(*_pLog, event.Data.UnsignedInt, 4);
+#else
+    WriteUInt(*_pLog, event.Data.UnsignedLong, 4);
+#endif
+    _pLog->write(id);
+    _pLog->write(priority);
+
+    _lastTime = now;
+    _recordCount++;
+}
+
+
+#if TASKSCHEDULER_VIRTUAL_CLOCK
+/*******************************************************************************
+EventReplayer
+*******************************************************************************/
+
+DEFINE_CLASSNAME(EventReplayer);
+
+
+static bool ReadUInt(Stream& in, uint32_t& value, uint8_t size)
+{
+    value = 0;
+
+    for (auto i = 0; i < size; i++)
+    {
+        auto b = in.read();
+
+        if (b < 0) return false;
+
+        value |= (uint32_t)b << (8 * i);
+    }
+
+    return true;
+}
+
+
+static bool ReadVarint(Stream& in, uint32_t& value)
+{
+    value = 0;
+
+    for (auto shift = 0; shift < 35; shift += 7)
+    {
+        auto b = in.read();
+
+        if (b < 0) return false;
+
+        value |= (uint32_t)(b & 0x7F) << shift;
+
+        if ((b & 0x80) == 0) return true;
+    }
+
+    return false;
+}
+
+
+bool EventReplayer::ReadHeader(Stream& log, uint32_t& startTime)
+{
+    for (auto i = 0u; i < sizeof(LOG_MAGIC); i++)
+    {
+        if (log.read() != LOG_MAGIC[i]) return false;
+    }
+
+    if (log.read() != EventRecorder::FORMAT_VERSION) return false;
+
+    return ReadUInt(log, startTime, 4);
+}
+
+
+bool EventReplayer::ReadRecord(Stream& log, uint32_t& time, Event& event, uint8_t& priority)
+{
+    uint32_t delta, eventID, data, id, level;
+
+    if (!ReadVarint(log, delta) || !ReadUInt(log, eventID, 2) || !ReadUInt(log, data, 4) || 
+        !ReadUInt(log, id, 1) || !ReadUInt(log, level, 1)) return false;
+
+    time += delta;
+    event = Event((EVENT_ID)eventID, data);
+    event.SetSource(EventRecorder::SourceFromId((uint8_t)id));
+    priority = (uint8_t)level;
+
+    return true;
+}
+
+
+//******************************************************************************
+// Advances to each deadline before the target time in turn and runs a pass
+// there, since a pass can report new deadlines that come before the others.
+// A deadline at the target time is served by the caller's pass.
+//******************************************************************************
+void EventReplayer::RunUntil(uint32_t time)
+{
+    uint32_t wakeup;
+    auto hasPassed = false;     // A pass has run at the current time
+
+    while (TaskClock::TakeWakeup(wakeup))
+    {
+        auto now = TaskClock::Millis();
+
+        // A deadline that is already due gets one pass at the current time; if
+        // it is reported again, the clock moves on a tick so replay progresses
+        if ((int32_t)(wakeup - now) <= 0) wakeup = hasPassed ? now + 1 : now;
+
+        if ((int32_t)(wakeup - time) >= 0)
+        {
+            TaskClock::WakeAt(wakeup);
+            break;
+        }
+
+        TaskClock::AdvanceTo(wakeup);
+        TaskManager::Dispatch();
+        hasPassed = true;
+    }
+
+    TaskClock::AdvanceTo(time);
+}
+
+
+uint32_t EventReplayer::Run(Stream& log)
+{
+    uint32_t time;
+    uint32_t count = 0;
+
+    if (!ReadHeader(log, time))
+    {
+        TRACE(Logger(_classname_) << F("Run: invalid log header") << endl);
+        return 0;
+    }
+
+    TaskClock::StartVirtual(time);
+
+    Event event;
+    uint8_t priority;
+
+    while (ReadRecord(log, time, event, priority))
+    {
+        // Deliver everything recorded at the previous time step before moving on
+        if (time != TaskClock::Millis())
+        {
+            if (EventQueue::Length() > 0) TaskManager::Dispatch();
+
+            RunUntil(time);
+        }
+
+        if (!EventQueue::Queue(event, priority))
+        {
+            TaskManager::Dispatch();
+            EventQueue::Queue(event, priority);
+        }
+
+        count++;
+    }
+
+    TaskManager::Dispatch();
+
+    TRACE(Logger(_classname_) << F("Run: replayed ") << count << F(" events") << endl);
+
+    return count;
+}
+#endif
@@ -0,0 +1,152 @@
+#pragma once
+/*******************************************************************************
+Header file for the EventRecorder and EventReplayer classes.
+*******************************************************************************/
+
+#include <RTL_StdLib.h>
+#include "TaskSchedulerConfig.h"
+#include "Event.h"
+#include "EventQueue.h"
+#include "EventSource.h"
+
+
+//******************************************************************************
+/// Records the events queued to the EventQueue to a compact binary log.
+///
+/// EventRecorder is a static singleton. Only events from sources registered
+/// with AddSource() are recorded; these are the program's inputs (sensors,
+/// switches, etc). Events generated internally by tasks and states are not
+/// recorded since replaying the inputs regenerates them.
+///
+/// Events are recorded as they are queued, with the priority they were queued
+/// at, so the log reflects the order and time in which they arrived and replay
+/// queues them exactly as they were. The recorder is an arrival monitor (see
+/// EventQueue::AddMonitor()), so sources that queue events from an ISR are
+/// recorded in the ISR. The log format is:
+///
+///     Header: 'R' 'T' 'L' 'E', version (1 byte), start time (4 bytes)
+///     Record: time delta (varint), EventID (2 bytes), Data (4 bytes),
+///             source id (1 byte), priority (1 byte)
+///
+/// Multi-byte values are little-endian. The time delta is the number of
+/// milliseconds since the previous record (or the start time) encoded as an
+/// unsigned LEB128 varint, so most records are 9 bytes.
+//******************************************************************************
+class EventRecorder
+{
+    DECLARE_CLASSNAME;
+
+    /*--------------------------------------------------------------------------
+    Constants
+    --------------------------------------------------------------------------*/
+    public: static const uint8_t FORMAT_VERSION = 2;
+
+    /*--------------------------------------------------------------------------
+    Constructors
+    --------------------------------------------------------------------------*/
+    private: EventRecorder() {};
+
+    /*--------------------------------------------------------------------------
+    Public interface
+    --------------------------------------------------------------------------*/
+    //**************************************************************************
+    /// Registers an input source whose events are recorded, or replayed, and
+    /// returns its id. Sources must be registered in the same order when
+    /// recording and replaying. Returns 0 if the source table is full.
+    //**************************************************************************
+    public: static uint8_t AddSource(EventSource& source);
+
+    //**************************************************************************
+    /// Returns the id of a registered source, or 0 if it is not registered.
+    //**************************************************************************
+    public: static uint8_t SourceId(const EventSource* pSource);
+
+    //**************************************************************************
+    /// Returns the source registered with an id, or nullptr.
+    //**************************************************************************
+    public: static EventSource* SourceFromId(uint8_t id);
+
+    //**************************************************************************
+    /// Starts recording to the specified output. The recorder is added to the
+    /// EventQueue's monitors, alongside any others.
+    //**************************************************************************
+    public: static void Begin(Print& log);
+
+    //**************************************************************************
+    /// Stops recording and removes the recorder from the EventQueue's monitors.
+    //**************************************************************************
+    public: static void End();
+
+    //**************************************************************************
+    /// Returns the number of events recorded since Begin().
+    //**************************************************************************
+    public: static uint32_t RecordCount() { return _recordCount; };
+
+    /*--------------------------------------------------------------------------
+    Internal implementation
+    --------------------------------------------------------------------------*/
+    /// EventQueue arrival monitor that records an event
+    private: static void Record(const Event& event, uint8_t priority);
+
+    private: static Print*       _pLog;
+    private: static uint32_t     _lastTime;
+    private: static uint32_t     _recordCount;
+    private: static EventSource* _sources[EVENT_SOURCE_MAX];
+    private: static uint8_t      _sourceCount;
+    private: static EventMonitorLink _monitor;
+};
+
+
+#if TASKSCHEDULER_VIRTUAL_CLOCK
+//******************************************************************************
+/// Replays an event log written by the EventRecorder.
+///
+/// EventReplayer is a static singleton intended for the Linux host. It switches
+/// the TaskClock to virtual time and feeds the recorded events into the
+/// EventQueue, running TaskManager::Dispatch() as it goes. Between events the
+/// clock jumps directly to the next recorded event or to the next deadline
+/// reported with TaskClock::WakeAt(), so a long recording replays as fast as
+/// the tasks and states can process it.
+///
+/// The input sources must be registered with EventRecorder::AddSource() in the
+/// same order as when the log was recorded. The clock is left in virtual mode
+/// when the replay completes; call TaskClock::StopVirtual() to leave it.
+/// ============================================================================
+/// IMPORTANT: Remove any idle wait (TaskManager::SetIdleWait(nullptr, 0))
+///            before replaying. The replayer finds the next deadline with
+///            TaskClock::TakeWakeup(), which the idle wait also consumes, so
+///            with an idle wait installed deadlines are lost and the clock
+///            skips over them.
+//******************************************************************************
+class EventReplayer
+{
+    DECLARE_CLASSNAME;
+
+    /*--------------------------------------------------------------------------
+    Constructors
+    --------------------------------------------------------------------------*/
+    private: EventReplayer() {};
+
+    /*--------------------------------------------------------------------------
+    Public interface
+    --------------------------------------------------------------------------*/
+    //**************************************************************************
+    /// Replays an event log. Returns the number of events replayed.
+    //**************************************************************************
+    public: static uint32_t Run(Stream& log);
+
+    //**************************************************************************
+    /// Advances the virtual clock to the specified time, dispatching at every
+    /// intervening deadline reported with TaskClock::WakeAt(), one deadline at
+    /// a time.
+    //**************************************************************************
+    public: static void RunUntil(uint32_t time);
+
+    /*--------------------------------------------------------------------------
+    Internal implementation
+    --------------------------------------------------------------------------*/
+    private: static bool ReadHeader(Stream& log, uint32_t& startTime);
+
+    private: static bool ReadRecord(Stream& log, uint32_t& time, Event& event, uint8_t& priority);
+};
+#endif
@@ -7,11 +7,57 @@ A base class for an object that sources events.
 #include "Event.h"
 #include "EventQueue.h"
 #include "EventBinding.h"
+#include "EventThrottle.h"
 #include "EventSource.h"
+#include "TaskClock.h"
 
 
 DEFINE_CLASSNAME(EventSource);
 
+#if TASKSCHEDULER_COMPACT
+EventSource* EventSource::_sources[EVENT_SOURCE_MAX];
+uint8_t      EventSource::_generations[EVENT_SOURCE_MAX];
+uint8_t      EventSource::_overflowCount = 0;
+
+
+//******************************************************************************
+// Registers the new source in the first free entry of the source table
+//******************************************************************************
+EventSource::EventSource() : _firstBinding(nullptr), _index(0)
+{
+#if TASKSCHEDULER_EVENT_THROTTLE
+    _firstThrottle = nullptr;
+#endif
+
+    for (uint8_t i = 0; i < EVENT_SOURCE_MAX; i++)
+    {
+        if (_sources[i] == nullptr)
+        {
+            _sources[i] = this;
+            _index = _generations[i] | (i + 1);
+            break;
+        }
+    }
+
+    if (_index == 0 && _overflowCount < 0xFF) _overflowCount++;
+
+    TRACE(if (_index == 0) Logger(_classname_, this) << F("Source table full (EVENT_SOURCE_MAX=") << EVENT_SOURCE_MAX << ')' << endl);
+}
+
+
+//******************************************************************************
+// Frees the source's entry in the source table and bumps its generation, so
+// events from this source that are still queued will find no source.
+//******************************************************************************
+EventSource::~EventSource()
+{
+    uint8_t entry = _index & INDEX_ENTRY_MASK;
+    if (entry == 0) return;
+    _sources[entry - 1] = nullptr;
+    _generations[entry - 1] += INDEX_GENERATION_STEP;
+}
+#endif
+
 
 //******************************************************************************
 // Add an event binding to this EventSource's list of bindings
@@ -85,29 +131,107 @@ void EventSource::Detach(IEventBinding& binding)
 }
 
 
+#if TASKSCHEDULER_EVENT_THROTTLE
 //******************************************************************************
-// Queues an event with the given event ID and data.
+// Adds a throttle to this EventSource's list of throttles
 //******************************************************************************
-void EventSource::QueueEvent(EVENT_ID eventID, variant_t eventData)
+void EventSource::Throttle(EventThrottle& throttle)
 {
-    TRACE(Logger(_classname_, this) << F("QueueEvent: eventID=") << _HEX(eventID) << endl);
+    throttle._nextThrottle = _firstThrottle;
+    _firstThrottle = &throttle;
+}
 
-    Event event(eventID, eventData); { event.Source = this; }
 
-    EventQueue::Queue(event);
+//******************************************************************************
+// Removes a throttle from this EventSource's list of throttles
+//******************************************************************************
+void EventSource::Unthrottle(EventThrottle& throttle)
+{
+    for (auto pLink = &_firstThrottle; *pLink != nullptr; pLink = &(*pLink)->_nextThrottle)
+    {
+        if (*pLink == &throttle)
+        {
+            *pLink = throttle._nextThrottle;
+            throttle._nextThrottle = nullptr;
+            break;
+        }
+    }
 }
 
 
+//******************************************************************************
+// Determines if an event is rejected by any of this EventSource's throttles.
+// Every throttle tests the event so that all of them track its timing, and the
+// event is committed as accepted only if none of them rejected it.
+//******************************************************************************
+bool EventSource::IsThrottled(const Event& event)
+{
+    auto now = TaskClock::Millis();
+    auto accepted = true;
+
+    for (auto pThrottle = _firstThrottle; pThrottle != nullptr; pThrottle = pThrottle->_nextThrottle)
+    {
+        accepted &= pThrottle->Test(event, now);
+    }
+
+    if (accepted)
+    {
+        for (auto pThrottle = _firstThrottle; pThrottle != nullptr; pThrottle = pThrottle->_nextThrottle)
+        {
+            pThrottle->Commit(event, now);
+        }
+    }
+
+    TRACE(if (!accepted) Logger(_classname_, this) << F("Throttled: eventID=") << _HEX(event.EventID) << endl);
+
+    return !accepted;
+}
+#endif
+
+
 //******************************************************************************
 // Queues an event with the given event ID and data.
 //******************************************************************************
-void EventSource::QueueEvent(Event& event)
+bool EventSource::QueueEvent(EVENT_ID eventID, variant_t eventData)
+{
+    Event event(eventID, eventData);
+
+    return QueueEvent(event);
+}
+
+
+//******************************************************************************
+// Queues an event with the priority derived from its event ID.
+//******************************************************************************
+bool EventSource::QueueEvent(Event& event)
+{
+    return QueueEvent(event, EventQueue::PriorityOf(event.EventID));
+}
+
+
+//******************************************************************************
+// Queues an event with the given priority.
+//******************************************************************************
+bool EventSource::QueueEvent(Event& event, uint8_t priority)
 {
     TRACE(Logger(_classname_, this) << F("QueueEvent: eventID=") << _HEX(event.EventID) << endl);
 
-    event.Source = this;
+#if TASKSCHEDULER_COMPACT
+    // The event could not be traced back to this source
+    if (_index == 0)
+    {
+        TRACE(Logger(_classname_, this) << F("QueueEvent: source has no index") << endl);
+        return false;
+    }
+#endif
+
+#if TASKSCHEDULER_EVENT_THROTTLE
+    if (_firstThrottle != nullptr && IsThrottled(event)) return false;
+#endif
 
-    EventQueue::Queue(event);
+    event.SetSource(this);
+
+    return EventQueue::Queue(event, priority);
 }
 
 
@@ -117,7 +241,7 @@ void EventSource::QueueEvent(Event& event)
 //******************************************************************************
 void EventSource::DispatchEvent(EVENT_ID eventID, variant_t eventData)
 {
-    Event event(eventID, eventData);  { event.Source = this; }
+    Event event(eventID, eventData);  { event.SetSource(this); }
 
     DispatchEvent(event);
 }
@@ -130,6 +254,16 @@ void EventSource::DispatchEvent(Event& event)
 {
     TRACE(Logger(_classname_, this) << F("DispatchEvent: eventID=") << _HEX(event.EventID) << endl);
 
+#if TASKSCHEDULER_EVENT_THROTTLE
+    if (_firstThrottle != nullptr && IsThrottled(event)) return;
+#endif
+
+    DeliverEvent(event);
+}
+
+
+void EventSource::DeliverEvent(Event& event)
+{
     for (IEventBinding* pBinding = _firstBinding; pBinding != nullptr; pBinding = pBinding->_nextLink)
     {
         pBinding->DispatchEvent(event);
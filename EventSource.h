@@ -4,6 +4,7 @@
 #include <inttypes.h>
 #include <RTL_Stdlib.h>
 #include <RTL_Variant.h>
+#include "TaskSchedulerConfig.h"
 #include "Event.h"
 #include "EventCodes.h"
 #include "IEventListener.h"
@@ -12,6 +13,7 @@
 class IEventBinding;
 class EventBinding;
 class StaticEventBinding;
+class EventThrottle;
 
 
 /*******************************************************************************
@@ -38,6 +40,22 @@ created. The EventDispatcher then calls the Poll() method of each EventSource
 whenever its DispatchEvents() method is called. To ensure events are detected
 and dispatched as expeditiously as possible, the EventDispatcher::DispatchEvents()
 method should be called on every iteration in a sketch's loop() method.
+
+In the compact profile (TASKSCHEDULER_COMPACT) each EventSource registers itself
+in a table of up to EVENT_SOURCE_MAX sources when it is constructed, and events
+refer to their source by its index in that table. A destroyed source frees its
+entry for reuse. The low 5 bits of the index select the entry and the high 3
+bits hold the entry's generation, which is bumped each time the entry is freed,
+so an event queued by a destroyed source does not resolve to a new source that
+reuses the entry (unless the entry is reused 8 times while the event is still
+queued). A source constructed while the table is full has no index (see
+Index() and OverflowCount()) and cannot queue events; QueueEvent() returns false.
+
+Events generated by a source can be debounced and rate limited by attaching one
+or more EventThrottle objects with the Throttle() method. Events rejected by a
+throttle are dropped in QueueEvent() and DispatchEvent(). An event is throttled
+only once: a queued event that EventQueue::Dispatch() delivers to the listeners
+is not throttled again.
 *******************************************************************************/
 class EventSource
 {
@@ -45,13 +63,23 @@ class EventSource
     
     friend class EventQueue;
     friend class IEventBinding;
+    friend struct Event;
 
     /***************************************************************************
     Constructors
     ***************************************************************************/
 
     /// The constructor is protected to enforce abstract base class semantics
-    protected: EventSource() { };
+#if TASKSCHEDULER_COMPACT
+    protected: EventSource();
+
+    /// Removes the source from the source table
+    public: ~EventSource();
+#elif TASKSCHEDULER_EVENT_THROTTLE
+    protected: EventSource() : _firstBinding(nullptr), _firstThrottle(nullptr) { };
+#else
+    protected: EventSource() : _firstBinding(nullptr) { };
+#endif
 
     /***************************************************************************
     Public Methods
@@ -67,15 +95,47 @@ class EventSource
     /// Determines if the source has any listeners attached
     public: bool HasListeners() { return _firstBinding != nullptr; };
 
+#if TASKSCHEDULER_EVENT_THROTTLE
+    /// Adds a debounce/rate limit throttle to this source
+    public: void Throttle(EventThrottle& throttle);
+
+    /// Removes a throttle from this source
+    public: void Unthrottle(EventThrottle& throttle);
+#endif
+
+#if TASKSCHEDULER_COMPACT
+    /// Returns the source's index in the source table (0 if it could not be indexed)
+    public: uint8_t Index() { return _index; };
+
+    /// Returns the source with the specified index, or nullptr if the entry
+    /// is free or now belongs to a source of a later generation
+    public: static EventSource* FromIndex(uint8_t index) 
+    { 
+        uint8_t entry = index & INDEX_ENTRY_MASK;
+        if (entry == 0 || entry > EVENT_SOURCE_MAX) return nullptr;
+        EventSource* pSource = _sources[entry - 1];
+        return (pSource != nullptr && pSource->_index == index) ? pSource : nullptr; 
+    };
+
+    /// Returns the number of sources that could not be indexed because the
+    /// source table was full (increase EVENT_SOURCE_MAX if this is not 0)
+    public: static uint8_t OverflowCount() { return _overflowCount; };
+#endif
+
     /***************************************************************************
     Protected Methods
     ***************************************************************************/
 
-    /// Creates and queues an event with the given event ID and data.
-    protected: void QueueEvent(EVENT_ID eventID, variant_t eventData=0L);
+    /// Creates and queues an event with the given event ID and data. Returns
+    /// false if the event was throttled, the queue is full, or (in the compact
+    /// profile) the source has no index.
+    protected: bool QueueEvent(EVENT_ID eventID, variant_t eventData=0L);
 
     /// Queues an event
-    protected: void QueueEvent(Event& pEvent);
+    protected: bool QueueEvent(Event& pEvent);
+
+    /// Queues an event with an explicit priority (see EventPriority)
+    protected: bool QueueEvent(Event& pEvent, uint8_t priority);
 
     /// Creates and dispatches an event with the given event ID and data to the
     /// attached listeners.
@@ -84,12 +144,47 @@ class EventSource
     /// Dispatches an event to the attached listeners.
     protected: void DispatchEvent(Event& pEvent);
 
+    /// Delivers an event to the attached listeners without throttling it (used
+    /// for events that were throttled when they were queued).
+    private: void DeliverEvent(Event& event);
+
     /***************************************************************************
     Internal state
     ***************************************************************************/
 
     /// The first binding in the binding chain (linked list)
     private: IEventBinding* _firstBinding;          // size = 2
+
+#if TASKSCHEDULER_EVENT_THROTTLE
+    /// Determines if an event is rejected by any of the source's throttles
+    private: bool IsThrottled(const Event& event);
+
+    /// The first throttle in the throttle chain (linked list)
+    private: EventThrottle* _firstThrottle;         // size = 2
+#endif
+
+#if TASKSCHEDULER_COMPACT
+    /// The index of this source in the source table (entry + 1 in the low
+    /// bits, the entry's generation in the high bits)
+    private: uint8_t _index;                        // size = 1
+    private: static const uint8_t INDEX_ENTRY_MASK = 0x1F;
+    private: static const uint8_t INDEX_GENERATION_STEP = INDEX_ENTRY_MASK + 1;
+
+    /// The source table (nullptr marks a free entry) and the generation of
+    /// each entry (in the high bits, as stored in the index)
+    private: static EventSource* _sources[EVENT_SOURCE_MAX];
+    private: static uint8_t _generations[EVENT_SOURCE_MAX];
+    private: static uint8_t _overflowCount;
+#endif
 };
 
+
+#if TASKSCHEDULER_COMPACT
+static_assert(EVENT_SOURCE_MAX > 0 && EVENT_SOURCE_MAX <= 31, "EVENT_SOURCE_MAX must be between 1 and 31");
+
+inline EventSource* Event::GetSource() const { return EventSource::FromIndex(SourceIndex); }
+
+inline void Event::SetSource(EventSource* pSource) { SourceIndex = (pSource != nullptr) ? pSource->_index : 0; }
+#endif
+
 #endif
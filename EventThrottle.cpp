@@ -0,0 +1,44 @@
+/*******************************************************************************
+Debounces and rate limits the events generated by an EventSource.
+*******************************************************************************/
+#define DEBUG 0
+
+#include <Arduino.h>
+#include "EventThrottle.h"
+
+
+//******************************************************************************
+// Determines if an event passes the throttle. Elapsed times are computed with
+// unsigned arithmetic so they remain correct when millis() wraps around.
+//******************************************************************************
+bool EventThrottle::Test(const Event& event, uint32_t now)
+{
+    if (_eventID != AnyEvent && _eventID != event.EventID) return true;
+
+    // The first event is always accepted by the debounce window
+    auto sinceLastEvent = now - _lastEventTime;
+    auto debounced      = _hasEvent && sinceLastEvent < _debounceWindow;
+
+    _hasEvent = true;
+    _lastEventTime = now;
+
+    if (debounced || (_hasAccepted && now - _lastAcceptedTime < _minInterval))
+    {
+        _suppressedCount++;
+        return false;
+    }
+
+    return true;
+}
+
+
+//******************************************************************************
+// Records an event accepted by every throttle on the source
+//******************************************************************************
+void EventThrottle::Commit(const Event& event, uint32_t now)
+{
+    if (_eventID != AnyEvent && _eventID != event.EventID) return;
+
+    _hasAccepted = true;
+    _lastAcceptedTime = now;
+}
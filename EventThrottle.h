@@ -0,0 +1,106 @@
+#ifndef _EventThrottleX_h_
+#define _EventThrottleX_h_
+
+#include <inttypes.h>
+#include <RTL_StdLib.h>
+#include "Event.h"
+
+
+/*******************************************************************************
+Debounces and rate limits the events generated by an EventSource.
+
+An event throttle is attached to an EventSource with EventSource::Throttle().
+The EventSource then consults its throttles in QueueEvent() and DispatchEvent()
+and drops any event a throttle rejects, so suppressed events never reach the
+EventQueue or the event listeners. Each event is checked once, when it is
+queued or dispatched.
+
+A throttle applies two independent limits, either of which can be zero to
+disable it:
+
+  - Debounce window: an event is rejected if the previous event of the same
+    kind (accepted or not) occurred less than the window ago. The first event
+    of a burst is passed and the rest of the burst is dropped until the source
+    has been quiet for the full window. This suits switches and keypads.
+    Only the leading edge is reported: the event that ends a bounce is
+    dropped with the rest of the burst, so a listener must not treat the
+    data of the accepted event as the settled state (e.g., of a switch that
+    bounced open and closed). Read the current state when it matters, for
+    example after a Timer set for the debounce window expires.
+
+  - Minimum interval: an event is rejected if less than the interval has
+    elapsed since the last accepted event. This caps the rate of high rate
+    sensors at 1000/interval events per second.
+
+A throttle can apply to all events from its source (AnyEvent) or only to
+events with a specific EVENT_ID. Multiple throttles can be attached to the same
+source; they are chained together as a linked list through the _nextThrottle
+member. An event must be accepted by every throttle that applies to it, and
+only an event accepted by all of them starts a new minimum interval.
+
+A throttle must only be attached to one source. If the source queues events
+from an ISR, the throttle is also evaluated in the ISR. Times are taken from
+TaskClock::Millis().
+*******************************************************************************/
+class EventThrottle
+{
+    friend class EventSource;
+
+    /*--------------------------------------------------------------------------
+    Constants
+    --------------------------------------------------------------------------*/
+    /// The EventID that matches every event from the source
+    public: static const EVENT_ID AnyEvent = 0xFFFF;
+
+    /*--------------------------------------------------------------------------
+    Constructors
+    --------------------------------------------------------------------------*/
+    public: EventThrottle(uint16_t debounceWindow, uint16_t minInterval = 0, EVENT_ID eventID = AnyEvent)
+        : _eventID(eventID), _debounceWindow(debounceWindow), _minInterval(minInterval), 
+          _lastEventTime(0), _lastAcceptedTime(0), _suppressedCount(0), _hasEvent(false), _hasAccepted(false), 
+          _nextThrottle(nullptr) { };
+
+    /*--------------------------------------------------------------------------
+    Public interface
+    --------------------------------------------------------------------------*/
+    /// Sets the debounce window (ms)
+    public: void SetDebounceWindow(uint16_t window) { _debounceWindow = window; };
+
+    /// Sets the minimum interval (ms) between accepted events
+    public: void SetMinInterval(uint16_t interval) { _minInterval = interval; };
+
+    /// Returns the number of events rejected by this throttle
+    public: uint16_t SuppressedCount() { return _suppressedCount; };
+
+    /// Determines if the event is accepted by this throttle. Records the
+    /// event's time for the debounce window, but not as an accepted event;
+    /// call Commit() once every throttle on the source has accepted it.
+    public: bool Test(const Event& event, uint32_t now);
+
+    /// Records the event as accepted, starting a new minimum interval
+    public: void Commit(const Event& event, uint32_t now);
+
+    /// Tests the event and, if accepted, commits it (for a throttle used on
+    /// its own)
+    public: bool Accept(const Event& event, uint32_t now) 
+    { 
+        if (!Test(event, now)) return false;
+        Commit(event, now);
+        return true;
+    };
+
+    /*--------------------------------------------------------------------------
+    Internal implementation
+    --------------------------------------------------------------------------*/
+    private: EVENT_ID _eventID;                 // size = 2
+    private: uint16_t _debounceWindow;          // size = 2
+    private: uint16_t _minInterval;             // size = 2
+    private: uint32_t _lastEventTime;           // size = 4
+    private: uint32_t _lastAcceptedTime;        // size = 4
+    private: uint16_t _suppressedCount;         // size = 2
+    private: bool     _hasEvent;                // size = 1
+    private: bool     _hasAccepted;             // size = 1
+    private: EventThrottle* _nextThrottle;      // size = 2
+};
+
+#endif
@@ -0,0 +1,130 @@
+/*******************************************************************************
+An EventSource that reports file descriptor readiness on the Linux host.
+*******************************************************************************/
+#if defined(__linux__)
+
+#define DEBUG 0
+
+#include <Arduino.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include "EventQueue.h"
+#include "FileEventSource.h"
+#include "RTL_TaskManager.h"
+
+
+DEFINE_CLASSNAME(FileEventSource);
+
+FileEventSource* FileEventSource::_pIdleSource = nullptr;
+
+
+static uint32_t ToEpollEvents(uint8_t interest)
+{
+    uint32_t events = 0;
+
+    if (interest & FileEventSource::Readable) events |= EPOLLIN;
+    if (interest & FileEventSource::Writable) events |= EPOLLOUT;
+
+    return events;
+}
+
+
+FileEventSource::FileEventSource()
+{
+    _epollFd = epoll_create1(EPOLL_CLOEXEC);
+
+    TRACE(if (_epollFd < 0) Logger(_classname_, this) << F("epoll_create1 failed") << endl);
+}
+
+
+FileEventSource::~FileEventSource()
+{
+    if (_pIdleSource == this)
+    {
+        TaskManager::SetIdleWait(nullptr, 0);
+        _pIdleSource = nullptr;
+    }
+
+    if (_epollFd >= 0) close(_epollFd);
+}
+
+
+bool FileEventSource::Add(int fd, uint8_t interest)
+{
+    epoll_event ev = { };
+
+    ev.events = ToEpollEvents(interest);
+    ev.data.fd = fd;
+
+    return epoll_ctl(_epollFd, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+
+bool FileEventSource::Modify(int fd, uint8_t interest)
+{
+    epoll_event ev = { };
+
+    ev.events = ToEpollEvents(interest);
+    ev.data.fd = fd;
+
+    return epoll_ctl(_epollFd, EPOLL_CTL_MOD, fd, &ev) == 0;
+}
+
+
+bool FileEventSource::Remove(int fd)
+{
+    return epoll_ctl(_epollFd, EPOLL_CTL_DEL, fd, nullptr) == 0;
+}
+
+
+//******************************************************************************
+// Waits for readiness and queues an event per ready condition. A descriptor can
+// report up to three conditions, so free EventQueue slots are counted per event:
+// conditions that don't fit (and descriptors beyond the free slots) stay ready
+// and are reported on the next call.
+//******************************************************************************
+int FileEventSource::Wait(uint32_t timeoutMs)
+{
+    static const int MAX_EVENTS = 16;
+
+    epoll_event ready[MAX_EVENTS];
+
+    auto freeSlots = EventQueue::Capacity() - EventQueue::Length();
+    auto maxEvents = (freeSlots < MAX_EVENTS) ? freeSlots : MAX_EVENTS;
+
+    // Nothing can be queued; don't block either
+    if (maxEvents <= 0) return 0;
+
+    auto count = epoll_wait(_epollFd, ready, maxEvents, (timeoutMs > INT32_MAX) ? -1 : (int)timeoutMs);
+    auto queued = 0;
+
+    for (auto i = 0; i < count; i++)
+    {
+        auto fd = (int32_t)ready[i].data.fd;
+        auto events = ready[i].events;
+
+        // A hung up descriptor can still have data to read, so report both
+        if ((events & EPOLLIN) && queued < freeSlots && QueueEvent(FileReadableEvent, fd)) queued++;
+        if ((events & EPOLLOUT) && queued < freeSlots && QueueEvent(FileWritableEvent, fd)) queued++;
+        if ((events & (EPOLLHUP | EPOLLERR)) && queued < freeSlots && QueueEvent(FileClosedEvent, fd)) queued++;
+    }
+
+    TRACE(if (count < 0) Logger(_classname_, this) << F("epoll_wait failed") << endl);
+
+    return queued;
+}
+
+
+void FileEventSource::UseAsIdleWait(uint32_t maxWait)
+{
+    _pIdleSource = this;
+    TaskManager::SetIdleWait(&FileEventSource::IdleWait, maxWait);
+}
+
+
+void FileEventSource::IdleWait(uint32_t timeoutMs)
+{
+    if (_pIdleSource != nullptr) _pIdleSource->Wait(timeoutMs);
+}
+
+#endif
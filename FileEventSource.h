@@ -0,0 +1,98 @@
+#ifndef _FileEventSourceX_h_
+#define _FileEventSourceX_h_
+
+#if defined(__linux__)
+
+#include <inttypes.h>
+#include <RTL_StdLib.h>
+#include "EventSource.h"
+
+
+/*******************************************************************************
+An EventSource that reports file descriptor readiness on the Linux host.
+
+File descriptors (sockets, serial ports, pipes, etc.) are registered with Add()
+and are monitored with epoll. When Wait() is called, each ready descriptor
+generates an event on the EventQueue:
+
+    FileReadableEvent   The descriptor can be read without blocking
+    FileWritableEvent   The descriptor can be written without blocking
+    FileClosedEvent     The descriptor was hung up or has an error
+
+The event data is the file descriptor. Descriptors are level triggered, so a
+descriptor that is still ready (for example, because the queue was full or the
+handler did not read all of the data) is reported again on the next Wait().
+Event handlers should therefore read or write until the descriptor would block,
+and should Remove() a descriptor once it reports FileClosedEvent.
+
+To make the TaskManager dispatch loop readiness driven, call UseAsIdleWait().
+When no event is queued and no task can run (see TaskManager::SetIdleWait()),
+TaskManager::Dispatch() then blocks in epoll_wait() until a descriptor is ready,
+a deadline reported with TaskClock::WakeAt() is due, or maxWait elapses, rather
+than busy polling.
+*******************************************************************************/
+class FileEventSource : public EventSource
+{
+    DECLARE_CLASSNAME;
+
+    /*--------------------------------------------------------------------------
+    Constants
+    --------------------------------------------------------------------------*/
+    /// Readiness conditions that can be monitored (combine with |)
+    public: enum Interest : uint8_t
+    {
+        Readable = 0x01,
+        Writable = 0x02,
+    };
+
+    /*--------------------------------------------------------------------------
+    Constructors
+    --------------------------------------------------------------------------*/
+    public: FileEventSource();
+
+    public: ~FileEventSource();
+
+    /*--------------------------------------------------------------------------
+    Public interface
+    --------------------------------------------------------------------------*/
+    //**************************************************************************
+    /// Starts monitoring a file descriptor. Returns false on error.
+    //**************************************************************************
+    public: bool Add(int fd, uint8_t interest = Readable);
+
+    //**************************************************************************
+    /// Changes the readiness conditions monitored for a file descriptor.
+    //**************************************************************************
+    public: bool Modify(int fd, uint8_t interest);
+
+    //**************************************************************************
+    /// Stops monitoring a file descriptor.
+    //**************************************************************************
+    public: bool Remove(int fd);
+
+    //**************************************************************************
+    /// Waits up to timeoutMs for descriptors to become ready and queues an
+    /// event for each ready condition. Returns the number of events queued.
+    //**************************************************************************
+    public: int Wait(uint32_t timeoutMs);
+
+    //**************************************************************************
+    /// Installs this source as the TaskManager idle wait.
+    //**************************************************************************
+    public: void UseAsIdleWait(uint32_t maxWait);
+
+    /*--------------------------------------------------------------------------
+    Internal implementation
+    --------------------------------------------------------------------------*/
+    private: static void IdleWait(uint32_t timeoutMs);
+
+    /// The source installed as the TaskManager idle wait
+    private: static FileEventSource* _pIdleSource;
+
+    /// The epoll instance
+    private: int _epollFd;
+};
+
+#endif
+
+#endif
@@ -0,0 +1,55 @@
+/*******************************************************************************
+Implementation file for the PeriodicTask class.
+*******************************************************************************/
+#define DEBUG 0
+
+#include <Arduino.h>
+#include "PeriodicTask.h"
+#include "TaskClock.h"
+
+#if TASKSCHEDULER_EDF
+
+void TaskSchedule::Complete(uint32_t finishTime)
+{
+    if ((int32_t)(finishTime - AbsoluteDeadline()) > 0 && MissedCount < 0xFFFF) MissedCount++;
+
+    Release += Period;
+
+    // Skip the jobs that can no longer finish in time
+    auto behind = (int32_t)(finishTime - AbsoluteDeadline());
+
+    if (behind > 0)
+    {
+        auto skipped = (uint32_t)behind / Period + 1;
+
+        Release += skipped * Period;
+        MissedCount = (MissedCount + skipped < 0xFFFF) ? MissedCount + skipped : 0xFFFF;
+    }
+}
+
+
+PeriodicTask::PeriodicTask(uint16_t period, uint16_t deadline)
+{
+    _schedule.Release = 0;
+    _schedule.MissedCount = 0;
+
+    SetPeriod(period, deadline);
+}
+
+
+void PeriodicTask::SetPeriod(uint16_t period, uint16_t deadline)
+{
+    _schedule.Period = (period != 0) ? period : 1;
+    _schedule.Deadline = (deadline != 0) ? deadline : _schedule.Period;
+}
+
+
+//******************************************************************************
+// Releases the first job as soon as the task resumes.
+//******************************************************************************
+void PeriodicTask::StateChanging(TaskState newState)
+{
+    if (newState == Resuming) _schedule.Release = TaskClock::Millis();
+}
+
+#endif
@@ -0,0 +1,88 @@
+#pragma once
+/*******************************************************************************
+Header file for the PeriodicTask class.
+*******************************************************************************/
+
+#include <RTL_StdLib.h>
+#include "TaskSchedulerConfig.h"
+#include "TaskBase.h"
+
+#if TASKSCHEDULER_EDF
+
+//******************************************************************************
+/// The timing of a periodic task: a job is released every Period ms and must
+/// finish within Deadline ms of its release.
+//******************************************************************************
+struct TaskSchedule         /* Size = 10 bytes */
+{
+    uint32_t Release;       // When the current job was (or will be) released
+    uint16_t Period;
+    uint16_t Deadline;      // Relative to the release
+    uint16_t MissedCount;   // Jobs that finished late or were skipped
+
+    /// Returns the absolute deadline of the current job
+    uint32_t AbsoluteDeadline() const { return Release + Deadline; };
+
+    /// Records that the current job finished at the specified time and
+    /// releases the next job. Jobs whose deadlines have already passed are
+    /// skipped and counted as missed.
+    void Complete(uint32_t finishTime);
+};
+
+
+//******************************************************************************
+/// The base class for a task with a period and a deadline.
+///
+/// In the EarliestDeadline dispatch mode (see TaskManager::SetDispatchMode()),
+/// a periodic task is polled once per period, and among the periodic tasks
+/// that are due, the one whose deadline is earliest is always polled first.
+/// A poll that finishes after the deadline counts as a missed deadline; see
+/// MissedCount(). Tasks that are not periodic run after the periodic tasks
+/// that are due, in task list order.
+///
+/// In the other dispatch modes a periodic task is polled like any other task.
+/// ============================================================================
+/// IMPORTANT: Derived classes that override StateChanging() must call
+/// PeriodicTask::StateChanging() so that the schedule restarts on resume.
+//******************************************************************************
+class PeriodicTask : public TaskBase
+{
+    /*--------------------------------------------------------------------------
+    Constructors
+    --------------------------------------------------------------------------*/
+    //**************************************************************************
+    /// Creates a task that runs every period ms and must finish within
+    /// deadline ms of the start of each period (0 = the period).
+    //**************************************************************************
+    protected: PeriodicTask(uint16_t period, uint16_t deadline = 0);
+
+    /*--------------------------------------------------------------------------
+    Public interface
+    --------------------------------------------------------------------------*/
+    //**************************************************************************
+    /// Changes the period and relative deadline (0 = the period).
+    //**************************************************************************
+    public: void SetPeriod(uint16_t period, uint16_t deadline = 0);
+
+    //**************************************************************************
+    /// Returns the number of missed deadlines since the count was reset.
+    //**************************************************************************
+    public: uint16_t MissedCount() { return _schedule.MissedCount; };
+    public: void ResetMissedCount() { _schedule.MissedCount = 0; };
+
+    /*--------------------------------------------------------------------------
+    Overrides
+    --------------------------------------------------------------------------*/
+    public: TaskSchedule* Schedule() override { return &_schedule; };
+
+    public: void StateChanging(TaskState newState) override;
+
+    public: const __FlashStringHelper* Name() override { return F("PeriodicTask"); };
+
+    /*--------------------------------------------------------------------------
+    Internal implementation
+    --------------------------------------------------------------------------*/
+    private: TaskSchedule _schedule;
+};
+
+#endif
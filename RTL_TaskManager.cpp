@@ -7,6 +7,12 @@ Implementation file for the TaskManager class.
 #include <RTL_Stdlib.h>
 #include <EventQueue.h>
 #include "RTL_TaskManager.h"
+#include "PeriodicTask.h"
+#include "RequestTracker.h"
+#include "SchedulerMetrics.h"
+#include "TaskClock.h"
+#include "TaskProfiler.h"
+#include "TimerService.h"
 
 
 DEFINE_CLASSNAME(TaskManager);
@@ -17,6 +23,17 @@ static TaskBase* EMPTY_TASK_LIST[] = { nullptr };
 TaskBase** TaskManager::_taskList = EMPTY_TASK_LIST;
 TaskBase** TaskManager::_taskPointer = EMPTY_TASK_LIST;
 StateBase* TaskManager::_pCurrentState = nullptr;
+#if TASKSCHEDULER_SIGNALS || TASKSCHEDULER_EDF
+DispatchMode TaskManager::_dispatchMode = PollAll;
+#endif
+#if TASKSCHEDULER_SIGNALS
+TaskBase* volatile TaskManager::_readyHead = nullptr;
+TaskBase* volatile TaskManager::_readyTail = nullptr;
+#endif
+IDLE_WAIT  TaskManager::_pfIdleWait = nullptr;
+uint32_t   TaskManager::_maxIdleWait = 0;
+uint32_t   TaskManager::_passBudget = 0;
+uint32_t   TaskManager::_passStart = 0;
 
 
 //******************************************************************************
@@ -25,36 +42,154 @@ StateBase* TaskManager::_pCurrentState = nullptr;
 //******************************************************************************
 void TaskManager::Dispatch()
 {
-    // Run all tasks in the task list
-    for (auto p = _taskList; *p; p++)
+#if TASKSCHEDULER_METRICS
+    SchedulerMetrics::BeginPass();
+#endif
+
+    // Wait for external work (e.g., I/O) if nothing is pending
+    if (_pfIdleWait != nullptr)
     {
-        TRACE(Logger(_classname_, F("Dispatch Task ")) << (*p)->Name() << '[' << PTR(*p) << ']' << endl);
+        uint32_t timeout = 0;
+        uint32_t wakeup;
+
+        if (EventQueue::Length() == 0 && !HasDueTasks())
+        {
+            timeout = _maxIdleWait;
+
+            if (TaskClock::TakeWakeup(wakeup))
+            {
+                auto untilWakeup = (int32_t)(wakeup - TaskClock::Millis());
+
+                if (untilWakeup <= 0) timeout = 0;
+                else if ((uint32_t)untilWakeup < timeout) timeout = untilWakeup;
+            }
+        }
+
+#if TASKSCHEDULER_PROFILER
+        TaskProfiler::EnterIdleWait();
+#endif
+
+        (*_pfIdleWait)(timeout);
+
+#if TASKSCHEDULER_PROFILER
+        TaskProfiler::Leave();
+#endif
+    }
 
-        (*p)->Run();
+#if TASKSCHEDULER_METRICS
+    SchedulerMetrics::EndPhase(IdlePhase);
+#endif
+
+    // The pass's time budget starts once there is work to do
+    if (_passBudget != 0) _passStart = micros();
+
+#if TASKSCHEDULER_TIMERS
+    // Expire timers so their events are delivered in this pass
+    TimerService::Poll();
+#endif
+
+#if TASKSCHEDULER_REQUESTS
+    // Time out requests whose responses are overdue
+    RequestTracker::Poll();
+#endif
+
+#if TASKSCHEDULER_METRICS
+    SchedulerMetrics::EndPhase(HousekeepingPhase);
+#endif
+
+#if TASKSCHEDULER_EDF
+    if (_dispatchMode == EarliestDeadline)
+    {
+        // Run the periodic tasks by deadline, then the others
+        RunByDeadline();
     }
+    else
+#endif
+#if TASKSCHEDULER_SIGNALS
+    if (_dispatchMode == SignaledOnly)
+    {
+        // Run only the tasks that have been signaled
+        RunSignaledTasks(true);
+    }
+    else
+#endif
+    {
+        // Run all tasks in the task list
+        for (auto p = _taskList; *p; p++)
+        {
+            TRACE(Logger(_classname_, F("Dispatch Task ")) << (*p)->Name() << '[' << PTR(*p) << ']' << endl);
+
+#if TASKSCHEDULER_PROFILER
+            TaskProfiler::EnterTask(*p);
+#endif
+
+            (*p)->Run();
+        }
+    }
+
+#if TASKSCHEDULER_METRICS
+    SchedulerMetrics::EndPhase(TaskPhase);
+#endif
 
     // Dispatch all events that were queued up to this point to the current state.
     // NOTE: This loop is specifically constructed to only go around the event queue
     // one time. It does NOT dispatch any new events added as a result of processing
-    // a dispatched event. Those will get processed on the next go-around. Otherwise, 
-    // we could create an endless loop where object A posts an event that object B 
-    // receives who, in turn, posts an event that object A receives, etc... In such 
-    // a scenario the event queue would never empty and the dispatch loop would go 
-    // on forever.
-    for (auto i = EventQueue::Length(); i > 0; i--)
+    // a dispatched event, whatever their priority (see EventQueue::Snapshot). Those
+    // will get processed on the next go-around. Otherwise, we could create an
+    // endless loop where object A posts an event that object B receives who, in
+    // turn, posts an event that object A receives, etc... In such a scenario the
+    // event queue would never empty and the dispatch loop would go on forever.
+    EventQueue::Snapshot snapshot;
+    Event event;
+
+    EventQueue::TakeSnapshot(snapshot);
+
+    while (EventQueue::Dequeue(event, snapshot))
     {
-        Event event;
+        TRACE(Logger(_classname_, F("Dispatch Event")) << F("ID=") << event.EventID << F(", Srce=") << PTR(event.GetSource()) << endl);
 
-        if (EventQueue::Dequeue(event))
-        {
-            TRACE(Logger(_classname_, F("Dispatch Event")) << F("ID=") << event.EventID << F(", Srce=") << PTR(event.Source) << endl);
+#if TASKSCHEDULER_PROFILER
+        TaskProfiler::EnterEvent(event.EventID);
+#endif
+
+#if TASKSCHEDULER_METRICS
+        SchedulerMetrics::CountEvent();
+#endif
 
-            if (_pCurrentState) _pCurrentState->OnEvent(&event);
+#if TASKSCHEDULER_REQUESTS
+        // A response to a tracked request completes the request instead
+        if (RequestTracker::Complete(event)) continue;
+#endif
+
+        if (_pCurrentState)
+        {
+#if TASKSCHEDULER_BACKOFF
+            // The state may have work to do now, so poll it at full rate
+            _pCurrentState->Wake();
+#endif
+            _pCurrentState->OnEvent(&event);
         }
     }
 
+#if TASKSCHEDULER_METRICS
+    SchedulerMetrics::EndPhase(EventPhase);
+#endif
+
+#if TASKSCHEDULER_PROFILER
+    TaskProfiler::EnterTask(_pCurrentState);
+#endif
+
     // Run the current state
     if (_pCurrentState) _pCurrentState->Run();
+
+#if TASKSCHEDULER_PROFILER
+    TaskProfiler::Leave();
+#endif
+
+#if TASKSCHEDULER_METRICS
+    SchedulerMetrics::EndPhase(StatePhase);
+    SchedulerMetrics::EndPass();
+#endif
 }
 
 
@@ -67,20 +202,33 @@ TaskBase** TaskManager::SetTaskList(TaskBase* newTaskList[], bool autoResume, bo
 {
     auto oldTaskList = _taskList;
 
-    // Suspend all tasks in the current task list
+    if (newTaskList == nullptr) newTaskList = EMPTY_TASK_LIST;
+
+#if TASKSCHEDULER_DATAFLOW
+    // Put producers ahead of their consumers (a list already in order, such as
+    // one installed before, is not changed)
+    OrderTaskList(newTaskList);
+#endif
+
+    // Suspend the tasks that are leaving, i.e., the tasks in the current task
+    // list that are not in the new one
     if (autoSuspend)
     {
+        MarkTaskList(_taskList, false);
+        MarkTaskList(newTaskList, true);
+
         for (auto p = _taskList; *p; p++)
         {
-            (*p)->Suspend();
+            if (!(*p)->_listMark) (*p)->Suspend();
         }
     }
 
     // Switch task lists and reset task pointer
-    _taskList = (newTaskList != nullptr) ? newTaskList : EMPTY_TASK_LIST;
+    _taskList = newTaskList;
     _taskPointer = _taskList;
 
-    // Resume all tasks in the new task list
+    // Resume all tasks in the new task list (tasks that kept running are
+    // unaffected)
     if (autoResume)
     {
         for (auto p = _taskList; *p; p++)
@@ -93,6 +241,70 @@ TaskBase** TaskManager::SetTaskList(TaskBase* newTaskList[], bool autoResume, bo
 }
 
 
+void TaskManager::MarkTaskList(TaskBase** taskList, bool mark)
+{
+    for (auto p = taskList; *p; p++) (*p)->_listMark = mark;
+}
+
+
+#if TASKSCHEDULER_DATAFLOW
+//******************************************************************************
+// Reorders the task list so that every task comes after the producers it
+// depends on. The relative order of independent tasks is preserved. If the
+// dependencies contain a cycle, the tasks in the cycle keep their list order.
+//
+// The list mark flags the tasks that are not placed yet, so a task is ready
+// when none of its producers is marked. A list that is already in order costs
+// O(n * p) for n tasks with up to p producers each; the worst case is
+// O(n^2 * p).
+//******************************************************************************
+void TaskManager::OrderTaskList(TaskBase* taskList[])
+{
+    // Producers outside the list never hold up a task
+    for (auto p = taskList; *p; p++)
+    {
+        for (auto pp = (*p)->_producers; pp != nullptr && *pp; pp++) (*pp)->_listMark = false;
+    }
+
+    MarkTaskList(taskList, true);
+
+    for (auto placed = taskList; *placed; placed++)
+    {
+        // Find the first unplaced task whose producers are all placed (or are
+        // not in this task list)
+        auto ready = placed;
+
+        for (; *ready; ready++)
+        {
+            auto isReady = true;
+
+            for (auto pp = (*ready)->_producers; pp != nullptr && *pp && isReady; pp++)
+            {
+                isReady = !(*pp)->_listMark || *pp == *ready;
+            }
+
+            if (isReady) break;
+        }
+
+        if (*ready == nullptr)
+        {
+            TRACE(Logger(_classname_) << F("OrderTaskList: dependency cycle at ") << (*placed)->Name() << endl);
+            (*placed)->_listMark = false;
+            continue;
+        }
+
+        // Rotate the ready task into place to keep the remaining order stable
+        auto pTask = *ready;
+
+        for (auto q = ready; q != placed; q--) *q = *(q - 1);
+
+        *placed = pTask;
+        pTask->_listMark = false;
+    }
+}
+#endif
+
+
 //******************************************************************************
 // Sets the current state machine state
 //******************************************************************************
@@ -112,6 +324,232 @@ StateBase* TaskManager::SetCurrentState(StateBase* pNewState)
 }
 
 
+#if TASKSCHEDULER_SIGNALS || TASKSCHEDULER_EDF
+//******************************************************************************
+// Sets the dispatch mode. Tasks left in the ready queue when leaving
+// SignaledOnly mode are released so they can be signaled again later.
+//******************************************************************************
+DispatchMode TaskManager::SetDispatchMode(DispatchMode mode)
+{
+    auto oldMode = _dispatchMode;
+
+#if TASKSCHEDULER_SIGNALS
+    if (oldMode == SignaledOnly && mode != SignaledOnly) RunSignaledTasks(false);
+#endif
+
+    _dispatchMode = mode;
+
+    return oldMode;
+}
+#endif
+
+
+#if TASKSCHEDULER_SIGNALS
+//******************************************************************************
+// Appends a task to the ready queue unless it is already queued. In PollAll
+// mode the task is polled anyway, so only its backoff is cancelled. A dataflow
+// consumer is made to run even if its producers have not changed, since the
+// signal says it has work to do.
+//******************************************************************************
+void TaskManager::Signal(TaskBase& task)
+{
+#if TASKSCHEDULER_BACKOFF
+    task.Wake();
+#endif
+#if TASKSCHEDULER_DATAFLOW
+    task._inputsStale = true;
+#endif
+
+    if (_dispatchMode != SignaledOnly) return;
+
+    noInterrupts(); // ATOMIC BLOCK BEGIN
+
+    if (!task._isSignaled)
+    {
+        task._isSignaled = true;
+        task._nextReady = nullptr;
+
+        if (_readyTail != nullptr) _readyTail->_nextReady = &task;
+        else _readyHead = &task;
+
+        _readyTail = &task;
+    }
+
+    interrupts();   // ATOMIC BLOCK END
+}
+
+
+//******************************************************************************
+// Detaches the ready queue and runs each task in it. Tasks signaled while this
+// is running (including by the tasks themselves) go on a new queue and run on
+// the next pass.
+//******************************************************************************
+void TaskManager::RunSignaledTasks(bool run)
+{
+    // Check for an empty queue before disabling interrupts (see EventQueue::Dequeue)
+    if (_readyHead == nullptr) return;
+
+    noInterrupts(); // ATOMIC BLOCK BEGIN
+
+    auto pTask = _readyHead;
+
+    _readyHead = _readyTail = nullptr;
+
+    interrupts();   // ATOMIC BLOCK END
+
+    while (pTask != nullptr)
+    {
+        auto pNext = pTask->_nextReady;
+
+        // Release the task before running it so it can be signaled again
+        noInterrupts();
+        pTask->_nextReady = nullptr;
+        pTask->_isSignaled = false;
+        interrupts();
+
+        if (run)
+        {
+            TRACE(Logger(_classname_, F("Dispatch Signaled Task ")) << pTask->Name() << '[' << PTR(pTask) << ']' << endl);
+
+#if TASKSCHEDULER_PROFILER
+            TaskProfiler::EnterTask(pTask);
+#endif
+
+            pTask->Run();
+        }
+
+        pTask = pNext;
+    }
+}
+#endif
+
+
+#if TASKSCHEDULER_EDF
+//******************************************************************************
+// Runs the periodic tasks that are due earliest deadline first, then the tasks
+// that are not periodic in task list order. Only jobs released by the start of
+// the pass run, so a task that overruns its period cannot starve the rest of
+// the pass. Each job is selected by scanning the whole task list, so a pass
+// that runs k jobs costs O(n*k) for n tasks; with the handful of periodic
+// tasks typical on a microcontroller this is cheaper, in both time and RAM,
+// than maintaining a priority queue.
+//******************************************************************************
+void TaskManager::RunByDeadline()
+{
+    auto passStart = TaskClock::Millis();
+
+    for (;;)
+    {
+        TaskBase*     pNext = nullptr;
+        TaskSchedule* pNextSchedule = nullptr;
+
+        for (auto p = _taskList; *p; p++)
+        {
+            auto pSchedule = (*p)->Schedule();
+
+            if (pSchedule == nullptr) continue;
+
+            // Let the task resume, which releases its first job
+            if ((*p)->_taskState == Resuming) (*p)->Run();
+
+            if (!(*p)->IsRunning() || (int32_t)(passStart - pSchedule->Release) < 0) continue;
+
+            if (pNext == nullptr || (int32_t)(pSchedule->AbsoluteDeadline() - pNextSchedule->AbsoluteDeadline()) < 0)
+            {
+                pNext = *p;
+                pNextSchedule = pSchedule;
+            }
+        }
+
+        if (pNext == nullptr) break;
+
+        TRACE(Logger(_classname_, F("Dispatch Periodic Task ")) << pNext->Name() << '[' << PTR(pNext) << ']' << endl);
+
+#if TASKSCHEDULER_PROFILER
+        TaskProfiler::EnterTask(pNext);
+#endif
+
+        pNext->Run();
+
+        pNextSchedule->Complete(TaskClock::Millis());
+    }
+
+    auto hasRelease = false;
+    uint32_t nextRelease = 0;
+
+    for (auto p = _taskList; *p; p++)
+    {
+        auto pSchedule = (*p)->Schedule();
+
+        if (pSchedule == nullptr)
+        {
+            TRACE(Logger(_classname_, F("Dispatch Task ")) << (*p)->Name() << '[' << PTR(*p) << ']' << endl);
+
+#if TASKSCHEDULER_PROFILER
+            TaskProfiler::EnterTask(*p);
+#endif
+
+            (*p)->Run();
+        }
+        else if ((*p)->IsRunning() && (!hasRelease || (int32_t)(pSchedule->Release - nextRelease) < 0))
+        {
+            nextRelease = pSchedule->Release;
+            hasRelease = true;
+        }
+    }
+
+    // Let the idle wait know when the next periodic job is released
+    if (hasRelease) TaskClock::WakeAt(nextRelease);
+}
+#endif
+
+
+//******************************************************************************
+// Determines if the pass has anything to run without waiting: the current state
+// or a task that is not suspended, backed off or dataflow clean, a released
+// periodic job in EarliestDeadline mode, or a signaled task in SignaledOnly
+// mode. Tasks that are not due report their next deadline with WakeAt().
+//******************************************************************************
+bool TaskManager::HasDueTasks()
+{
+    if (_pCurrentState != nullptr && _pCurrentState->IsDue()) return true;
+
+#if TASKSCHEDULER_SIGNALS
+    if (_dispatchMode == SignaledOnly) return _readyHead != nullptr;
+#endif
+
+    for (auto p = _taskList; *p; p++)
+    {
+#if TASKSCHEDULER_EDF
+        auto pSchedule = (*p)->Schedule();
+
+        if (_dispatchMode == EarliestDeadline && pSchedule != nullptr)
+        {
+            // RunByDeadline() reports the next release with WakeAt()
+            if ((*p)->_taskState == Resuming) return true;
+            if ((*p)->IsRunning() && (int32_t)(TaskClock::Millis() - pSchedule->Release) >= 0) return true;
+
+            continue;
+        }
+#endif
+
+        if ((*p)->IsDue()) return true;
+    }
+
+    return false;
+}
+
+
+//******************************************************************************
+// Sets the idle wait function
+//******************************************************************************
+void TaskManager::SetIdleWait(IDLE_WAIT pfIdleWait, uint32_t maxWait)
+{
+    _pfIdleWait = pfIdleWait;
+    _maxIdleWait = maxWait;
+}
+
+
 //******************************************************************************
 // Determines if the specified task is in the task list.
 //******************************************************************************
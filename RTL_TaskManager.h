@@ -11,6 +11,20 @@ Header file for the TaskManager class.
 #include "EventQueue.h"
 
 
+/// The ways TaskManager::Dispatch() can select the tasks to run.
+enum DispatchMode
+{
+    PollAll,            // Poll every running task in the task list on each pass
+    SignaledOnly,       // Only run tasks that have been signaled since the last pass
+    EarliestDeadline,   // Run released PeriodicTasks earliest deadline first
+};
+
+
+/// Signature of a function that blocks until there is work to do or the
+/// timeout expires (e.g., FileEventSource::IdleWait()).
+typedef void (*IDLE_WAIT)(uint32_t timeoutMs);
+
+
 //******************************************************************************
 /// The TaskManager is a static singleton class that implements a dispatch loop
 /// to execute a list of tasks.
@@ -20,7 +34,8 @@ Header file for the TaskManager class.
 /// be added or removed from the task list. However, individual tasks in the task
 /// list can be suspended to effectively remove them from execution. In addition,
 /// the task list can be changed at any time via SetTaskList() so that you can
-/// dynamically supply different task lists as needed.
+/// dynamically supply different task lists as needed. Running tasks that appear
+/// in both the old and the new task list are not suspended and resumed again.
 /// 
 /// The TaskManager class also provides a basic state machine implementation.
 /// A state is just a special task that is a subclass of the StateBase class 
@@ -28,6 +43,23 @@ Header file for the TaskManager class.
 /// StateBase that repersents the currently active state, which is set by the 
 /// SetCurrentState() method. The TaskManager::Dispatch() method polls the active
 /// state after all other task have been polled.
+///
+/// In SignaledOnly dispatch mode the task list is not walked at all. Instead,
+/// each pass runs the tasks that have called TaskBase::Signal() since the
+/// previous pass, in the order they were signaled, so the cost of a pass is
+/// proportional to the work to be done rather than to the size of the task
+/// list. The current state is still run and receives events on every pass.
+///
+/// In EarliestDeadline dispatch mode, each pass runs the PeriodicTasks whose
+/// period has come around, always choosing the one with the earliest deadline
+/// next, and then gives the remaining tasks one turn each in list order.
+///
+/// Response events that answer a request tracked by the RequestTracker
+/// complete that request and are not delivered to the current state.
+///
+/// If tasks in a task list declare producers (see TaskBase::DependsOn()),
+/// SetTaskList() sorts the list in place (see OrderTaskList()) so that
+/// producers are polled before their consumers.
 /// ============================================================================
 /// IMPORTANT: The task list *MUST* be terminiated with a null entry to mark the
 ///            end of the list.
@@ -56,11 +88,29 @@ class TaskManager           /* Size = 6 bytes (16 bit) or 12 bytes (32 bit) */
     //**************************************************************************
     /// Sets the current task list. Returns the previously active task list;
     ///
+    /// Only the tasks that leave are suspended, so a running task that is in
+    /// both lists keeps running without a state change.
+    ///
+    /// With TASKSCHEDULER_DATAFLOW, the new list is ordered in place by
+    /// OrderTaskList() before it is installed. A list that is already in order
+    /// (e.g., one installed before) is left as is.
+    ///
     /// IMPORTANT: The task list *MUST* be terminiated with a null entry to mark
     ///            the end of the list.
     //**************************************************************************
     public: static TaskBase** SetTaskList(TaskBase* newTaskList[], bool autoeResume=true, bool autoSuspend=true);
 
+#if TASKSCHEDULER_DATAFLOW
+    //**************************************************************************
+    /// Reorders a task list in place so that every task comes after the
+    /// producers it depends on; the relative order of independent tasks is
+    /// preserved. SetTaskList() calls it, so the dependencies must be declared
+    /// before a task list is installed; call it directly only to order a list
+    /// ahead of time.
+    //**************************************************************************
+    public: static void OrderTaskList(TaskBase* taskList[]);
+#endif
+
     //**************************************************************************
     /// Sets the current state machine state task. Returns the previously active
     /// state task;
@@ -68,6 +118,53 @@ class TaskManager           /* Size = 6 bytes (16 bit) or 12 bytes (32 bit) */
     public: static StateBase* SetCurrentState(StateBase* pNewState);
     public: static StateBase* SetCurrentState(StateBase& newState) { return SetCurrentState(&newState); };
 
+    //**************************************************************************
+    /// Sets a function that Dispatch() calls at the start of each pass to wait
+    /// for external work, such as I/O readiness. The wait timeout is zero when
+    /// events are queued or any task can run, otherwise it is the time until
+    /// the earliest deadline reported with TaskClock::WakeAt(), but no more
+    /// than maxWait. A task can only run if it is not suspended, backed off
+    /// (see TaskBase::PollWork()) or waiting for its producers (see
+    /// TaskBase::DependsOn()); in SignaledOnly mode only signaled tasks can
+    /// run, and in EarliestDeadline mode only released periodic tasks. The
+    /// same applies to the current state. So a plain task that is polled on
+    /// every pass keeps the wait from blocking. Passing nullptr removes the
+    /// idle wait. The idle wait takes the deadline reported with WakeAt(), so
+    /// it cannot be used while an EventReplayer is running.
+    //**************************************************************************
+    public: static void SetIdleWait(IDLE_WAIT pfIdleWait, uint32_t maxWait);
+
+    //**************************************************************************
+    /// Sets the time budget for the work done in each Dispatch() pass, in
+    /// microseconds. Long running tasks check TaskBase::ShouldYield() and
+    /// return once the budget has been used up. Zero (the default) means no
+    /// budget, so ShouldYield() is always false.
+    //**************************************************************************
+    public: static void SetPassBudget(uint32_t budgetUs) { _passBudget = budgetUs; };
+
+    //**************************************************************************
+    /// Determines if the current pass has used up its time budget.
+    //**************************************************************************
+    public: static bool IsPassBudgetSpent()
+    {
+        return _passBudget != 0 && (uint32_t)(micros() - _passStart) >= _passBudget;
+    };
+
+#if TASKSCHEDULER_SIGNALS || TASKSCHEDULER_EDF
+    //**************************************************************************
+    /// Sets how Dispatch() selects the tasks to run. Returns the previous mode.
+    //**************************************************************************
+    public: static DispatchMode SetDispatchMode(DispatchMode mode);
+#endif
+
+#if TASKSCHEDULER_SIGNALS
+    //**************************************************************************
+    /// Places a task on the ready queue (see TaskBase::Signal()). Can be
+    /// called from an ISR.
+    //**************************************************************************
+    public: static void Signal(TaskBase& task);
+#endif
+
     //**************************************************************************
     /// Determines if a task is in the scheduler queue.
     //**************************************************************************
@@ -82,6 +179,24 @@ class TaskManager           /* Size = 6 bytes (16 bit) or 12 bytes (32 bit) */
     /*--------------------------------------------------------------------------
     Internal implementation
     --------------------------------------------------------------------------*/
+#if TASKSCHEDULER_SIGNALS
+    /// Runs (or, in PollAll mode, just releases) the tasks in the ready queue
+    /// as of the start of the call.
+    private: static void RunSignaledTasks(bool run);
+#endif
+
+    /// Determines if any task (or the current state) can run in this pass.
+    private: static bool HasDueTasks();
+
+    /// Sets the list mark of every task in a task list (see SetTaskList()).
+    private: static void MarkTaskList(TaskBase** taskList, bool mark);
+
+#if TASKSCHEDULER_EDF
+    /// Runs the released periodic tasks earliest deadline first, then the
+    /// other tasks in list order. O(n*k) for n tasks and k released jobs.
+    private: static void RunByDeadline();
+#endif
+
     /// The task list array containing pointers to tasks. 
     /// IMPORTANT: The task list *MUST* be terminiated with a null entry to
     ///            mark the end of the list.
@@ -92,4 +207,23 @@ class TaskManager           /* Size = 6 bytes (16 bit) or 12 bytes (32 bit) */
 
     /// The pointer to the current state machine state task.
     private: static StateBase* _pCurrentState;
+
+#if TASKSCHEDULER_SIGNALS || TASKSCHEDULER_EDF
+    /// The dispatch mode.
+    private: static DispatchMode _dispatchMode;
+#endif
+
+#if TASKSCHEDULER_SIGNALS
+    /// The ready queue of signaled tasks (FIFO).
+    private: static TaskBase* volatile _readyHead;
+    private: static TaskBase* volatile _readyTail;
+#endif
+
+    /// The idle wait function and the longest time it may block.
+    private: static IDLE_WAIT _pfIdleWait;
+    private: static uint32_t _maxIdleWait;
+
+    /// The time budget of a pass and the time (micros()) the current pass began.
+    private: static uint32_t _passBudget;
+    private: static uint32_t _passStart;
 };
@@ -0,0 +1,174 @@
+/*******************************************************************************
+Implementation file for the Request and RequestTracker classes.
+*******************************************************************************/
+#define DEBUG 0
+
+#include <Arduino.h>
+#include <RTL_Stdlib.h>
+#include "EventCodes.h"
+#include "RequestTracker.h"
+#include "TaskBase.h"
+#include "TaskClock.h"
+
+#if TASKSCHEDULER_REQUESTS
+
+/*******************************************************************************
+Request
+*******************************************************************************/
+
+RequestStatus Request::Status() const
+{
+    auto pSlot = RequestTracker::Find(_id);
+
+    return (pSlot != nullptr) ? pSlot->Status : RequestUnknown;
+}
+
+
+int16_t Request::Result() const
+{
+    auto pSlot = RequestTracker::Find(_id);
+
+    return (pSlot != nullptr && pSlot->Status == RequestComplete) ? pSlot->Result : 0;
+}
+
+
+void Request::Cancel()
+{
+    auto pSlot = RequestTracker::Find(_id);
+
+    if (pSlot == nullptr || pSlot->Status != RequestPending) return;
+
+    pSlot->Status = RequestUnknown;
+    RequestTracker::_pendingCount--;
+}
+
+
+/*******************************************************************************
+RequestTracker
+*******************************************************************************/
+
+DEFINE_CLASSNAME(RequestTracker);
+
+RequestTracker::Slot RequestTracker::_slots[REQUEST_SLOTS];
+uint8_t              RequestTracker::_pendingCount = 0;
+
+
+//******************************************************************************
+// Allocates a slot that is not pending, preferring slots that hold no result
+// so that completed results stay available for as long as possible.
+//******************************************************************************
+Request RequestTracker::Issue(uint32_t timeoutMs, REQUEST_CALLBACK pfCallback, TaskBase* pWaiter)
+{
+    Slot* pSlot = nullptr;
+
+    for (auto i = 0; i < REQUEST_SLOTS; i++)
+    {
+        auto status = _slots[i].Status;
+
+        if (status == RequestUnknown) { pSlot = &_slots[i]; break; }
+
+        if (status != RequestPending && pSlot == nullptr) pSlot = &_slots[i];
+    }
+
+    if (pSlot == nullptr)
+    {
+        TRACE(Logger(_classname_) << F("Issue: no free slot") << endl);
+        return Request();
+    }
+
+    if (++pSlot->Generation == 0) pSlot->Generation = 1;
+
+    pSlot->Callback = pfCallback;
+    pSlot->Waiter = pWaiter;
+    pSlot->Deadline = TaskClock::Millis() + timeoutMs;
+    pSlot->Result = 0;
+    pSlot->Status = RequestPending;
+
+    _pendingCount++;
+
+    TaskClock::WakeAt(pSlot->Deadline);
+
+    return Request(((uint16_t)pSlot->Generation << 8) | (uint16_t)(pSlot - _slots));
+}
+
+
+RequestTracker::Slot* RequestTracker::Find(uint16_t id)
+{
+    auto index = (uint8_t)id;
+
+    if (index >= REQUEST_SLOTS) return nullptr;
+
+    auto pSlot = &_slots[index];
+
+    return (pSlot->Generation == (uint8_t)(id >> 8) && id != 0) ? pSlot : nullptr;
+}
+
+
+bool RequestTracker::Complete(const Event& event)
+{
+    if ((event.EventID & 0x00FF) != EventCode::Response || _pendingCount == 0) return false;
+
+    auto pSlot = Find(IdOf(&event));
+
+    if (pSlot == nullptr || pSlot->Status != RequestPending) return false;
+
+    Finish(*pSlot, RequestComplete, ValueOf(&event));
+
+    return true;
+}
+
+
+void RequestTracker::Finish(Slot& slot, RequestStatus status, int16_t result)
+{
+    TRACE(Logger(_classname_) << F("Finish: slot=") << (uint16_t)(&slot - _slots) << F(", status=") << status << endl);
+
+    slot.Status = status;
+    slot.Result = result;
+    _pendingCount--;
+
+    if (slot.Callback != nullptr)
+    {
+        (*slot.Callback)(((uint16_t)slot.Generation << 8) | (uint16_t)(&slot - _slots), status, result);
+    }
+
+    if (slot.Waiter != nullptr)
+    {
+#if TASKSCHEDULER_SIGNALS
+        slot.Waiter->Signal();
+#elif TASKSCHEDULER_BACKOFF
+        slot.Waiter->Wake();
+#endif
+    }
+}
+
+
+void RequestTracker::Poll()
+{
+    if (_pendingCount == 0) return;
+
+    auto now = TaskClock::Millis();
+    auto hasDeadline = false;
+    uint32_t earliest = 0;
+
+    for (auto i = 0; i < REQUEST_SLOTS; i++)
+    {
+        auto& slot = _slots[i];
+
+        if (slot.Status != RequestPending) continue;
+
+        if ((int32_t)(now - slot.Deadline) >= 0)
+        {
+            Finish(slot, RequestTimedOut, 0);
+        }
+        else if (!hasDeadline || (int32_t)(slot.Deadline - earliest) < 0)
+        {
+            earliest = slot.Deadline;
+            hasDeadline = true;
+        }
+    }
+
+    // Let the idle wait know when the next request times out
+    if (hasDeadline) TaskClock::WakeAt(earliest);
+}
+
+#endif
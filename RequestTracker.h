@@ -0,0 +1,171 @@
+#pragma once
+/*******************************************************************************
+Header file for the Request and RequestTracker classes.
+*******************************************************************************/
+
+#include <RTL_StdLib.h>
+#include "TaskSchedulerConfig.h"
+#include "Event.h"
+
+#if TASKSCHEDULER_REQUESTS
+
+class TaskBase;
+
+
+/// The states of a tracked request.
+enum RequestStatus : uint8_t
+{
+    RequestUnknown,         // Not a tracked request (or its slot has been reused)
+    RequestPending,         // Waiting for a response
+    RequestComplete,        // The response arrived
+    RequestTimedOut,        // No response arrived in time
+};
+
+
+/// Signature of a function notified when a request completes or times out.
+typedef void (*REQUEST_CALLBACK)(uint16_t requestId, RequestStatus status, int16_t result);
+
+
+//******************************************************************************
+/// A handle to a request issued with RequestTracker::Issue().
+///
+/// The handle is just the request's correlation id, so it can be copied freely
+/// and polled like a future. A completed request's result remains available
+/// until its slot is reused by a later request.
+//******************************************************************************
+class Request               /* Size = 2 bytes */
+{
+    public: Request() : _id(0) { };
+    public: Request(uint16_t id) : _id(id) { };
+
+    /// Returns the correlation id (0 if no request was issued)
+    public: uint16_t Id() const { return _id; };
+
+    /// Returns the current status of the request
+    public: RequestStatus Status() const;
+
+    /// Determines if the request has completed or timed out
+    public: bool IsDone() const { auto status = Status(); return status == RequestComplete || status == RequestTimedOut; };
+
+    /// Returns the result carried by the response (0 until it completes)
+    public: int16_t Result() const;
+
+    /// Abandons a pending request without notifying its callback or waiter
+    public: void Cancel();
+
+    private: uint16_t _id;
+};
+
+
+//******************************************************************************
+/// Correlates command events with their responses.
+///
+/// RequestTracker is a static singleton. Issue() allocates a request slot and
+/// returns a Request whose correlation id the requester sends in its command
+/// event (see MakeData()). The responder returns the id in its response event,
+/// an event with the EventCode::Response code (e.g., TaskResponseEvent),
+/// optionally with a 16 bit result. TaskManager::Dispatch() passes every
+/// response event to Complete(), which finds the request from the id in O(1):
+/// the low byte of the id is the slot index and the high byte is a generation
+/// number that rejects stale ids. The response then completes the request and
+/// is not delivered to the current state. Responses that do not match a
+/// pending request are delivered as usual.
+///
+/// A completed request notifies its callback, if any, and signals its waiting
+/// task, if any, so that a task (for example, a ContinuationTask that yields
+/// until Request::IsDone()) runs on the next pass. Requests that receive no
+/// response within their timeout complete with RequestTimedOut.
+///
+/// Event data layout: the correlation id is in the low 16 bits. In the full
+/// profile the high 16 bits carry a signed argument or result; the compact
+/// profile's 16 bit event data carries only the id.
+///
+/// Example:
+///
+///     // Requester (a task that waits for the response)
+///     _turn = RequestTracker::Issue(2000, nullptr, this);
+///     QueueEvent(TurnCommandEvent, RequestTracker::MakeData(_turn.Id(), 90));
+///     ...
+///     if (_turn.Status() == RequestComplete) { ... _turn.Result() ... }
+///
+///     // Responder
+///     QueueEvent(TaskResponseEvent, RequestTracker::MakeData(RequestTracker::IdOf(pEvent), result));
+//******************************************************************************
+class RequestTracker
+{
+    DECLARE_CLASSNAME;
+
+    friend class Request;
+
+    /*--------------------------------------------------------------------------
+    Constructors
+    --------------------------------------------------------------------------*/
+    private: RequestTracker() {};
+
+    /*--------------------------------------------------------------------------
+    Public interface
+    --------------------------------------------------------------------------*/
+    //**************************************************************************
+    /// Starts tracking a request that times out after timeoutMs. The callback
+    /// and the waiting task are optional. Returns a Request with id 0 if all
+    /// slots are pending.
+    //**************************************************************************
+    public: static Request Issue(uint32_t timeoutMs, REQUEST_CALLBACK pfCallback = nullptr, TaskBase* pWaiter = nullptr);
+
+    //**************************************************************************
+    /// Completes the request that a response event refers to. Returns false if
+    /// the event is not a response to a pending request.
+    //**************************************************************************
+    public: static bool Complete(const Event& event);
+
+    //**************************************************************************
+    /// Times out the pending requests whose deadlines have passed. Called by
+    /// TaskManager::Dispatch().
+    //**************************************************************************
+    public: static void Poll();
+
+    //**************************************************************************
+    /// Returns the number of pending requests.
+    //**************************************************************************
+    public: static uint8_t PendingCount() { return _pendingCount; };
+
+    //**************************************************************************
+    /// Packs a correlation id and a signed 16 bit value into event data, and
+    /// unpacks them from an event.
+    //**************************************************************************
+    public: static int32_t MakeData(uint16_t id, int16_t value = 0) { return (int32_t)(((uint32_t)(uint16_t)value << 16) | id); };
+
+    public: static uint16_t IdOf(const Event* pEvent) { return pEvent->Data.UnsignedInt; };
+
+#if TASKSCHEDULER_COMPACT
+    public: static int16_t ValueOf(const Event* pEvent) { return 0; };
+#else
+    public: static int16_t ValueOf(const Event* pEvent) { return (int16_t)(pEvent->Data.UnsignedLong >> 16); };
+#endif
+
+    /*--------------------------------------------------------------------------
+    Internal implementation
+    --------------------------------------------------------------------------*/
+    private: struct Slot
+    {
+        REQUEST_CALLBACK Callback;
+        TaskBase*        Waiter;
+        uint32_t         Deadline;
+        int16_t          Result;
+        uint8_t          Generation;    // High byte of the current id (never 0)
+        RequestStatus    Status;
+    };
+
+    /// Returns the slot an id refers to, or nullptr if the id is stale
+    private: static Slot* Find(uint16_t id);
+
+    /// Finishes a pending request and notifies its callback and waiter
+    private: static void Finish(Slot& slot, RequestStatus status, int16_t result);
+
+    private: static Slot    _slots[REQUEST_SLOTS];
+    private: static uint8_t _pendingCount;
+};
+
+static_assert(REQUEST_SLOTS > 0 && REQUEST_SLOTS <= 255, "REQUEST_SLOTS must be between 1 and 255");
+
+#endif
@@ -0,0 +1,164 @@
+/*******************************************************************************
+Implementation file for the SchedulerMetrics class.
+*******************************************************************************/
+#define DEBUG 0
+
+#include <Arduino.h>
+#include <RTL_Stdlib.h>
+#include "SchedulerMetrics.h"
+
+#if TASKSCHEDULER_METRICS
+
+DEFINE_CLASSNAME(SchedulerMetrics);
+
+SchedulerMetrics::PhaseStats SchedulerMetrics::_phases[PHASE_COUNT];
+uint32_t         SchedulerMetrics::_histogram[METRICS_HISTOGRAM_BINS];
+uint32_t         SchedulerMetrics::_passStart = 0;
+uint32_t         SchedulerMetrics::_phaseStart = 0;
+uint32_t         SchedulerMetrics::_passCount = 0;
+uint32_t         SchedulerMetrics::_periodCount = 0;
+uint32_t         SchedulerMetrics::_periodMin = 0;
+uint32_t         SchedulerMetrics::_periodMax = 0;
+uint32_t         SchedulerMetrics::_overrunCount = 0;
+uint16_t         SchedulerMetrics::_passEvents = 0;
+uint16_t         SchedulerMetrics::_eventsLast = 0;
+uint16_t         SchedulerMetrics::_eventsMax = 0;
+uint32_t         SchedulerMetrics::_eventsTotal = 0;
+uint32_t         SchedulerMetrics::_watchdogThreshold = 0;
+METRICS_WATCHDOG SchedulerMetrics::_pfWatchdog = nullptr;
+
+
+//******************************************************************************
+// Records the loop period since the previous pass started (except before the
+// first pass) and starts timing the idle phase.
+//******************************************************************************
+void SchedulerMetrics::BeginPass()
+{
+    auto now = micros();
+
+    if (_passCount != 0)
+    {
+        auto period = now - _passStart;
+        uint8_t bin = 0;
+
+        while (bin < METRICS_HISTOGRAM_BINS - 1 && period >= BinLimit(bin)) bin++;
+
+        _histogram[bin]++;
+
+        if (_periodCount == 0 || period < _periodMin) _periodMin = period;
+        if (period > _periodMax) _periodMax = period;
+
+        _periodCount++;
+    }
+
+    _passStart = _phaseStart = now;
+    _passEvents = 0;
+}
+
+
+void SchedulerMetrics::EndPhase(DispatchPhase phase)
+{
+    auto now = micros();
+    auto duration = now - _phaseStart;
+    auto& stats = _phases[phase];
+
+    stats.Last = duration;
+    stats.Total += duration;
+    if (duration > stats.Max) stats.Max = duration;
+
+    _phaseStart = now;
+}
+
+
+//******************************************************************************
+// Records the events dispatched in the pass and calls the watchdog if the work
+// of the pass (everything but the idle wait) took too long.
+//******************************************************************************
+void SchedulerMetrics::EndPass()
+{
+    _passCount++;
+
+    _eventsLast = _passEvents;
+    _eventsTotal += _passEvents;
+    if (_passEvents > _eventsMax) _eventsMax = _passEvents;
+
+    auto work = (_phaseStart - _passStart) - _phases[IdlePhase].Last;
+
+    if (_pfWatchdog != nullptr && work > _watchdogThreshold)
+    {
+        _overrunCount++;
+
+        TRACE(Logger(_classname_) << F("EndPass: pass took ") << work << F("us") << endl);
+
+        (*_pfWatchdog)(work);
+    }
+}
+
+
+void SchedulerMetrics::SetWatchdog(uint32_t thresholdUs, METRICS_WATCHDOG pfWatchdog)
+{
+    _watchdogThreshold = thresholdUs;
+    _pfWatchdog = pfWatchdog;
+}
+
+
+void SchedulerMetrics::Reset()
+{
+    for (auto i = 0; i < PHASE_COUNT; i++) _phases[i] = PhaseStats();
+    for (auto i = 0; i < METRICS_HISTOGRAM_BINS; i++) _histogram[i] = 0;
+
+    // The next pass starts a new period measurement
+    _passCount = 0;
+    _periodCount = 0;
+    _periodMin = _periodMax = 0;
+    _overrunCount = 0;
+    _eventsLast = _eventsMax = 0;
+    _eventsTotal = 0;
+}
+
+
+const __FlashStringHelper* SchedulerMetrics::PhaseName(DispatchPhase phase)
+{
+    switch (phase)
+    {
+        case IdlePhase:         return F("Idle");
+        case HousekeepingPhase: return F("Housekeeping");
+        case TaskPhase:         return F("Tasks");
+        case EventPhase:        return F("Events");
+        default:                return F("State");
+    }
+}
+
+
+void SchedulerMetrics::Dump(const __FlashStringHelper* message)
+{
+    Logger(_classname_) << F("Metrics - ") << message << F(" (") << _passCount << F(" passes, ") << _overrunCount << F(" overruns)") << endl;
+
+    if (_passCount == 0) return;
+
+    for (auto i = 0; i < PHASE_COUNT; i++)
+    {
+        auto& stats = _phases[i];
+
+        Logger(_classname_) << PhaseName((DispatchPhase)i) << F(": last=") << stats.Last << F("us, max=") << stats.Max << F("us, mean=") << PhaseMean((DispatchPhase)i) << F("us") << endl;
+    }
+
+    Logger(_classname_) << F("Events per pass: last=") << _eventsLast << F(", max=") << _eventsMax << F(", total=") << _eventsTotal << endl;
+    Logger(_classname_) << F("Period: min=") << PeriodMin() << F("us, max=") << _periodMax << F("us, jitter=") << _periodMax - PeriodMin() << F("us") << endl;
+
+    for (uint8_t bin = 0; bin < METRICS_HISTOGRAM_BINS; bin++)
+    {
+        if (_histogram[bin] == 0) continue;
+
+        if (bin < METRICS_HISTOGRAM_BINS - 1)
+        {
+            Logger(_classname_) << F("    < ") << BinLimit(bin) << F("us: ") << _histogram[bin] << endl;
+        }
+        else
+        {
+            Logger(_classname_) << F("    >= ") << BinLimit(bin - 1) << F("us: ") << _histogram[bin] << endl;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,173 @@
+#pragma once
+/*******************************************************************************
+Header file for the SchedulerMetrics class.
+*******************************************************************************/
+
+#include <RTL_StdLib.h>
+#include "TaskSchedulerConfig.h"
+
+#if TASKSCHEDULER_METRICS
+
+/// The phases of a TaskManager::Dispatch() pass.
+enum DispatchPhase : uint8_t
+{
+    IdlePhase,              // Waiting for work (see TaskManager::SetIdleWait())
+    HousekeepingPhase,      // Expiring timers and requests
+    TaskPhase,              // Running the tasks
+    EventPhase,             // Delivering events to the current state
+    StatePhase,             // Running the current state
+};
+
+
+/// Signature of a function notified when a pass exceeds the watchdog threshold.
+typedef void (*METRICS_WATCHDOG)(uint32_t passUs);
+
+
+//******************************************************************************
+/// Health metrics of the TaskManager dispatch loop.
+///
+/// SchedulerMetrics is a static singleton with a fixed size block of counters
+/// that TaskManager::Dispatch() updates on every pass (six calls to micros()
+/// per pass). For each phase of a pass it keeps the duration of the last
+/// pass, the longest duration and the total. It also keeps a histogram of the
+/// loop period (the time from the start of one pass to the start of the next,
+/// including the idle wait), the shortest and longest period, and the number
+/// of events dispatched per pass.
+///
+/// A watchdog function set with SetWatchdog() is called at the end of any
+/// pass whose work (the pass excluding the idle wait) took longer than the
+/// threshold, so slowdowns can be reported before they cause control
+/// failures.
+///
+/// Example:
+///
+///     void OnSlowPass(uint32_t passUs) { digitalWrite(ALARM_PIN, HIGH); }
+///     ...
+///     SchedulerMetrics::SetWatchdog(2000, OnSlowPass);
+///     ...
+///     SchedulerMetrics::Dump(F("Hourly"));
+///     SchedulerMetrics::Reset();
+//******************************************************************************
+class SchedulerMetrics
+{
+    DECLARE_CLASSNAME;
+
+    /*--------------------------------------------------------------------------
+    Constructors
+    --------------------------------------------------------------------------*/
+    private: SchedulerMetrics() {};
+
+    /*--------------------------------------------------------------------------
+    Public interface
+    --------------------------------------------------------------------------*/
+    public: static const uint8_t PHASE_COUNT = StatePhase + 1;
+
+    //**************************************************************************
+    /// Records the start of a pass, the end of a phase, a dispatched event and
+    /// the end of a pass. Called by the TaskManager.
+    //**************************************************************************
+    public: static void BeginPass();
+    public: static void EndPhase(DispatchPhase phase);
+    public: static void CountEvent() { _passEvents++; };
+    public: static void EndPass();
+
+    //**************************************************************************
+    /// Calls pfWatchdog at the end of each pass whose work took longer than
+    /// thresholdUs. Pass nullptr to disable the watchdog.
+    //**************************************************************************
+    public: static void SetWatchdog(uint32_t thresholdUs, METRICS_WATCHDOG pfWatchdog);
+
+    //**************************************************************************
+    /// Clears the metrics (the watchdog is kept).
+    //**************************************************************************
+    public: static void Reset();
+
+    //**************************************************************************
+    /// Returns the number of passes measured and the number of passes that
+    /// exceeded the watchdog threshold.
+    //**************************************************************************
+    public: static uint32_t PassCount() { return _passCount; };
+    public: static uint32_t OverrunCount() { return _overrunCount; };
+
+    //**************************************************************************
+    /// Returns the duration of a phase in the last pass, its longest duration,
+    /// its total duration over all passes, and its mean duration, in
+    /// microseconds. The total is 64 bit so it doesn't wrap (a 32 bit total of
+    /// microseconds wraps after about 71 minutes).
+    //**************************************************************************
+    public: static uint32_t PhaseLast(DispatchPhase phase) { return _phases[phase].Last; };
+    public: static uint32_t PhaseMax(DispatchPhase phase) { return _phases[phase].Max; };
+    public: static uint64_t PhaseTotal(DispatchPhase phase) { return _phases[phase].Total; };
+    public: static uint32_t PhaseMean(DispatchPhase phase)
+    {
+        return (_passCount != 0) ? (uint32_t)(_phases[phase].Total / _passCount) : 0;
+    };
+
+    //**************************************************************************
+    /// Returns the shortest and the longest loop period in microseconds (the
+    /// difference is the loop jitter), and the number of periods in a bin of
+    /// the loop period histogram.
+    //**************************************************************************
+    public: static uint32_t PeriodMin() { return (_periodCount != 0) ? _periodMin : 0; };
+    public: static uint32_t PeriodMax() { return _periodMax; };
+    public: static uint32_t PeriodCount(uint8_t bin) { return (bin < METRICS_HISTOGRAM_BINS) ? _histogram[bin] : 0; };
+
+    //**************************************************************************
+    /// Returns the exclusive upper limit of a histogram bin in microseconds
+    /// (0 for the last bin, which has no limit).
+    //**************************************************************************
+    public: static uint32_t BinLimit(uint8_t bin)
+    {
+        return (bin < METRICS_HISTOGRAM_BINS - 1) ? (uint32_t)METRICS_HISTOGRAM_BASE_US << bin : 0;
+    };
+
+    //**************************************************************************
+    /// Returns the number of events dispatched in the last pass, the most in
+    /// any pass, and the total.
+    //**************************************************************************
+    public: static uint16_t EventsLast() { return _eventsLast; };
+    public: static uint16_t EventsMax() { return _eventsMax; };
+    public: static uint32_t EventsTotal() { return _eventsTotal; };
+
+    //**************************************************************************
+    /// Diagnostic method to display the metrics.
+    //**************************************************************************
+    public: static void Dump(const __FlashStringHelper* message = nullptr);
+
+    /*--------------------------------------------------------------------------
+    Internal implementation
+    --------------------------------------------------------------------------*/
+    private: static const __FlashStringHelper* PhaseName(DispatchPhase phase);
+
+    private: struct PhaseStats
+    {
+        uint32_t Last;
+        uint32_t Max;
+        uint64_t Total;
+    };
+
+    private: static PhaseStats _phases[PHASE_COUNT];
+    private: static uint32_t   _histogram[METRICS_HISTOGRAM_BINS];
+
+    /// The start of the current pass and of the current phase (micros)
+    private: static uint32_t _passStart;
+    private: static uint32_t _phaseStart;
+
+    private: static uint32_t _passCount;
+    private: static uint32_t _periodCount;
+    private: static uint32_t _periodMin;
+    private: static uint32_t _periodMax;
+    private: static uint32_t _overrunCount;
+
+    private: static uint16_t _passEvents;
+    private: static uint16_t _eventsLast;
+    private: static uint16_t _eventsMax;
+    private: static uint32_t _eventsTotal;
+
+    private: static uint32_t         _watchdogThreshold;
+    private: static METRICS_WATCHDOG _pfWatchdog;
+};
+
+static_assert(METRICS_HISTOGRAM_BINS >= 2 && METRICS_HISTOGRAM_BINS <= 24, "METRICS_HISTOGRAM_BINS must be between 2 and 24");
+
+#endif
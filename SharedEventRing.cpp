@@ -0,0 +1,279 @@
+/*******************************************************************************
+Implementation file for the SharedEventRing and SharedEventReader classes.
+*******************************************************************************/
+#define DEBUG 0
+
+#if defined(__linux__)
+
+#include <Arduino.h>
+#include <RTL_Stdlib.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "EventSource.h"
+#include "SharedEventRing.h"
+#include "TaskClock.h"
+
+
+/*******************************************************************************
+SharedEventRing
+*******************************************************************************/
+
+DEFINE_CLASSNAME(SharedEventRing);
+
+SharedEventRing::Header* SharedEventRing::_pHeader = nullptr;
+char                     SharedEventRing::_name[64];
+EventMonitorLink         SharedEventRing::_monitor(&SharedEventRing::Publish);
+EventSource*             SharedEventRing::_sources[EVENT_SOURCE_MAX];
+uint8_t                  SharedEventRing::_sourceCount = 0;
+
+
+bool SharedEventRing::Begin(const char* name, uint32_t capacity)
+{
+    End();
+
+    uint32_t size = 1;
+
+    while (size < capacity) size <<= 1;
+
+    auto fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+
+    if (fd < 0)
+    {
+        TRACE(Logger(_classname_) << F("Begin: shm_open failed") << endl);
+        return false;
+    }
+
+    auto regionSize = RegionSize(size);
+    struct stat st;
+
+    if (fstat(fd, &st) < 0 || ((size_t)st.st_size != regionSize && ftruncate(fd, regionSize) < 0))
+    {
+        close(fd);
+        return false;
+    }
+
+    auto pRegion = mmap(nullptr, regionSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    close(fd);
+
+    if (pRegion == MAP_FAILED) return false;
+
+    auto pHeader = (Header*)pRegion;
+
+    // Continue an existing ring with the same geometry; otherwise start afresh.
+    if (!(__atomic_load_n(&pHeader->Magic, __ATOMIC_ACQUIRE) == MAGIC
+          && pHeader->Version == FORMAT_VERSION
+          && pHeader->SlotSize == sizeof(Slot)
+          && pHeader->Capacity == size))
+    {
+        __atomic_store_n(&pHeader->Magic, 0, __ATOMIC_RELEASE);
+
+        memset(Slots(pHeader), 0, (size_t)size * sizeof(Slot));
+        pHeader->Version = FORMAT_VERSION;
+        pHeader->SlotSize = sizeof(Slot);
+        pHeader->Capacity = size;
+        pHeader->WriteIndex = 0;
+
+        __atomic_store_n(&pHeader->Magic, MAGIC, __ATOMIC_RELEASE);
+    }
+
+    strncpy(_name, name, sizeof(_name) - 1);
+    _pHeader = pHeader;
+    EventQueue::AddMonitor(_monitor);
+
+    TRACE(Logger(_classname_) << F("Begin: capacity=") << size << endl);
+
+    return true;
+}
+
+
+void SharedEventRing::End(bool remove)
+{
+    if (_pHeader == nullptr) return;
+
+    EventQueue::RemoveMonitor(_monitor);
+
+    munmap(_pHeader, RegionSize(_pHeader->Capacity));
+
+    if (remove) shm_unlink(_name);
+
+    _pHeader = nullptr;
+}
+
+
+uint8_t SharedEventRing::AddSource(EventSource& source)
+{
+    auto id = SourceId(&source);
+
+    if (id != 0 || _sourceCount >= EVENT_SOURCE_MAX) return id;
+
+    _sources[_sourceCount++] = &source;
+
+    return _sourceCount;
+}
+
+
+uint8_t SharedEventRing::SourceId(const EventSource* pSource)
+{
+    for (uint8_t i = 0; i < _sourceCount; i++)
+    {
+        if (_sources[i] == pSource) return i + 1;
+    }
+
+    return 0;
+}
+
+
+uint64_t SharedEventRing::EventCount()
+{
+    return (_pHeader != nullptr) ? _pHeader->WriteIndex : 0;
+}
+
+
+//******************************************************************************
+// Writes an event to the next slot. The slot's sequence is cleared while the
+// record is written, then set to the record's position + 1 before the write
+// index is advanced, so readers never accept a partially written record.
+//******************************************************************************
+void SharedEventRing::Publish(const Event& event)
+{
+    auto pHeader = _pHeader;
+
+    if (pHeader == nullptr) return;
+
+    auto index = pHeader->WriteIndex;
+    auto pSlot = &Slots(pHeader)[index & (pHeader->Capacity - 1)];
+
+    __atomic_store_n(&pSlot->Sequence, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    pSlot->Record.Time = TaskClock::Millis();
+#if TASKSCHEDULER_COMPACT
+    pSlot->Record.Data = event.Data.UnsignedInt;
+#else
+    pSlot->Record.Data = event.Data.UnsignedLong;
+#endif
+    pSlot->Record.EventID = event.EventID;
+    pSlot->Record.SourceId = SourceId(event.GetSource());
+    pSlot->Record.Reserved = 0;
+
+    __atomic_store_n(&pSlot->Sequence, index + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&pHeader->WriteIndex, index + 1, __ATOMIC_RELEASE);
+}
+
+
+/*******************************************************************************
+SharedEventReader
+*******************************************************************************/
+
+DEFINE_CLASSNAME(SharedEventReader);
+
+
+bool SharedEventReader::Open(const char* name)
+{
+    Close();
+
+    auto fd = shm_open(name, O_RDONLY, 0);
+
+    if (fd < 0) return false;
+
+    struct stat st;
+    void* pRegion = MAP_FAILED;
+
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(SharedEventRing::Header))
+    {
+        pRegion = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+
+    close(fd);
+
+    if (pRegion == MAP_FAILED) return false;
+
+    auto pHeader = (SharedEventRing::Header*)pRegion;
+
+    if (__atomic_load_n(&pHeader->Magic, __ATOMIC_ACQUIRE) != SharedEventRing::MAGIC
+        || pHeader->Version != SharedEventRing::FORMAT_VERSION
+        || pHeader->SlotSize != sizeof(SharedEventRing::Slot)
+        || SharedEventRing::RegionSize(pHeader->Capacity) > (size_t)st.st_size)
+    {
+        TRACE(Logger(_classname_, this) << F("Open: not an event ring") << endl);
+        munmap(pRegion, st.st_size);
+        return false;
+    }
+
+    _pHeader = pHeader;
+    _size = st.st_size;
+    _readIndex = __atomic_load_n(&pHeader->WriteIndex, __ATOMIC_ACQUIRE);
+    _lostCount = 0;
+
+    return true;
+}
+
+
+void SharedEventReader::Close()
+{
+    if (_pHeader == nullptr) return;
+
+    munmap(_pHeader, _size);
+
+    _pHeader = nullptr;
+}
+
+
+uint64_t SharedEventReader::Backlog()
+{
+    if (_pHeader == nullptr) return 0;
+
+    return __atomic_load_n(&_pHeader->WriteIndex, __ATOMIC_ACQUIRE) - _readIndex;
+}
+
+
+bool SharedEventReader::Read(SharedEventRecord& record)
+{
+    if (_pHeader == nullptr) return false;
+
+    auto capacity = _pHeader->Capacity;
+    auto pSlots = SharedEventRing::Slots(_pHeader);
+
+    // The writer recreated the ring with a larger capacity; the reader must reopen it
+    if (SharedEventRing::RegionSize(capacity) > _size) return false;
+
+    for (;;)
+    {
+        auto writeIndex = __atomic_load_n(&_pHeader->WriteIndex, __ATOMIC_ACQUIRE);
+
+        if (writeIndex == _readIndex) return false;
+
+        // The writer restarted with a fresh ring
+        if (writeIndex < _readIndex) _readIndex = 0;
+
+        // Skip records that have already been overwritten
+        if (writeIndex - _readIndex > capacity)
+        {
+            _lostCount += writeIndex - capacity - _readIndex;
+            _readIndex = writeIndex - capacity;
+        }
+
+        auto pSlot = &pSlots[_readIndex & (capacity - 1)];
+        auto sequence = __atomic_load_n(&pSlot->Sequence, __ATOMIC_ACQUIRE);
+
+        memcpy(&record, (const void*)&pSlot->Record, sizeof(record));
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        auto valid = sequence == _readIndex + 1
+                  && __atomic_load_n(&pSlot->Sequence, __ATOMIC_RELAXED) == sequence;
+
+        _readIndex++;
+
+        if (valid) return true;
+
+        // Overwritten while it was being read
+        _lostCount++;
+    }
+}
+
+#endif
@@ -0,0 +1,204 @@
+#pragma once
+/*******************************************************************************
+Header file for the SharedEventRing and SharedEventReader classes.
+*******************************************************************************/
+
+#if defined(__linux__)
+
+#include <RTL_StdLib.h>
+#include "TaskSchedulerConfig.h"
+#include "Event.h"
+#include "EventQueue.h"
+#include "EventSource.h"
+
+
+//******************************************************************************
+/// An event as published to a shared event ring.
+//******************************************************************************
+struct SharedEventRecord        /* Size = 12 bytes */
+{
+    uint32_t Time;              // TaskClock::Millis() when the event was delivered
+    uint32_t Data;              // The event data (16 bits in the compact profile)
+    EVENT_ID EventID;
+    uint8_t  SourceId;          // SharedEventRing::SourceId() of the source, or 0
+    uint8_t  Reserved;
+};
+
+
+//******************************************************************************
+/// Publishes the events delivered by the EventQueue to a named shared memory
+/// region so that other processes (e.g., monitoring or telemetry) can observe
+/// them without slowing the control process.
+///
+/// SharedEventRing is a static singleton for the Linux host. The region holds a
+/// single-writer, multi-reader broadcast ring of SharedEventRecords. Events are
+/// published from an EventQueue monitor as they are dequeued; publishing
+/// is a handful of memory stores, with no locks and no system calls. The
+/// writer never waits for readers. Each reader (see SharedEventReader) tails
+/// the ring at its own pace and detects, and counts, the events it missed when
+/// it falls more than a ring's length behind.
+///
+/// Sources registered with AddSource() are identified in each record by their
+/// id, in registration order starting at 1; records from other sources have
+/// source id 0. The ids are independent of the EventRecorder's.
+///
+/// Each slot is stamped with the position of the record it holds (position + 1,
+/// 0 while it is being written), so a reader can verify that the slot was not
+/// overwritten while it was copying it.
+///
+/// If the region already exists with the same geometry (e.g., the control
+/// process restarted), publishing continues from its current position so that
+/// attached readers keep their place. The region persists after End() unless
+/// it is removed.
+//******************************************************************************
+class SharedEventRing
+{
+    DECLARE_CLASSNAME;
+
+    friend class SharedEventReader;
+
+    /*--------------------------------------------------------------------------
+    Constants
+    --------------------------------------------------------------------------*/
+    public: static const uint32_t MAGIC = 0x45534C52;      // 'RLSE'
+    public: static const uint16_t FORMAT_VERSION = 1;
+
+    /*--------------------------------------------------------------------------
+    Constructors
+    --------------------------------------------------------------------------*/
+    private: SharedEventRing() {};
+
+    /*--------------------------------------------------------------------------
+    Public interface
+    --------------------------------------------------------------------------*/
+    //**************************************************************************
+    /// Creates (or reopens) the shared memory region with the specified name
+    /// (e.g., "/robot_events") and starts publishing events to it. The capacity
+    /// is rounded up to a power of two. Returns false if the region could not
+    /// be created.
+    //**************************************************************************
+    public: static bool Begin(const char* name, uint32_t capacity = 4096);
+
+    //**************************************************************************
+    /// Registers a source to identify in the published records and returns
+    /// its id. Returns 0 if the source table is full.
+    //**************************************************************************
+    public: static uint8_t AddSource(EventSource& source);
+
+    //**************************************************************************
+    /// Returns the id of a registered source, or 0 if it is not registered.
+    //**************************************************************************
+    public: static uint8_t SourceId(const EventSource* pSource);
+
+    //**************************************************************************
+    /// Stops publishing and unmaps the region. If remove is true the region is
+    /// also deleted; attached readers keep their mapping until they close it.
+    //**************************************************************************
+    public: static void End(bool remove = false);
+
+    //**************************************************************************
+    /// Returns the total number of events published to the region.
+    //**************************************************************************
+    public: static uint64_t EventCount();
+
+    /*--------------------------------------------------------------------------
+    Internal implementation
+    --------------------------------------------------------------------------*/
+    private: struct Slot
+    {
+        uint64_t          Sequence;     // Position + 1 of the record, 0 while writing
+        SharedEventRecord Record;
+    };
+
+    private: struct Header              /* Size = 64 bytes */
+    {
+        uint32_t Magic;                 // Set last when the region is initialized
+        uint16_t Version;
+        uint16_t SlotSize;
+        uint32_t Capacity;              // Power of two
+        uint32_t Reserved;
+        uint64_t WriteIndex;            // Position of the next record
+        uint8_t  Padding[40];
+    };
+
+    static_assert(sizeof(Header) == 64, "SharedEventRing::Header has an unexpected size");
+
+    /// Returns the size of a region with the specified capacity
+    private: static size_t RegionSize(uint32_t capacity) { return sizeof(Header) + (size_t)capacity * sizeof(Slot); };
+
+    /// Returns the slots that follow a region's header
+    private: static Slot* Slots(Header* pHeader) { return (Slot*)(pHeader + 1); };
+
+    /// EventQueue monitor that publishes an event
+    private: static void Publish(const Event& event);
+
+    private: static Header*          _pHeader;
+    private: static char             _name[64];
+    private: static EventMonitorLink _monitor;
+    private: static EventSource*     _sources[EVENT_SOURCE_MAX];
+    private: static uint8_t          _sourceCount;
+};
+
+
+//******************************************************************************
+/// Reads the events published to a SharedEventRing, typically in another
+/// process.
+///
+/// A reader starts at the ring's current position and reads forward. If the
+/// writer gets more than a ring's length ahead, the oldest unread records are
+/// overwritten; Read() then skips to the oldest record still available and
+/// adds the records skipped to LostCount().
+//******************************************************************************
+class SharedEventReader
+{
+    DECLARE_CLASSNAME;
+
+    /*--------------------------------------------------------------------------
+    Constructors
+    --------------------------------------------------------------------------*/
+    public: SharedEventReader() : _pHeader(nullptr), _size(0), _readIndex(0), _lostCount(0) { };
+
+    public: ~SharedEventReader() { Close(); };
+
+    /*--------------------------------------------------------------------------
+    Public interface
+    --------------------------------------------------------------------------*/
+    //**************************************************************************
+    /// Maps the shared memory region with the specified name. Returns false if
+    /// the region does not exist (yet) or is not a compatible event ring.
+    //**************************************************************************
+    public: bool Open(const char* name);
+
+    //**************************************************************************
+    /// Unmaps the region.
+    //**************************************************************************
+    public: void Close();
+
+    //**************************************************************************
+    /// Reads the next record. Returns false if no new record is available.
+    //**************************************************************************
+    public: bool Read(SharedEventRecord& record);
+
+    //**************************************************************************
+    /// Returns the number of records missed because the reader fell behind.
+    //**************************************************************************
+    public: uint64_t LostCount() { return _lostCount; };
+
+    //**************************************************************************
+    /// Returns the number of published records not read yet (including any
+    /// that have already been overwritten).
+    //**************************************************************************
+    public: uint64_t Backlog();
+
+    /*--------------------------------------------------------------------------
+    Internal implementation
+    --------------------------------------------------------------------------*/
+    private: SharedEventRing::Header* _pHeader;
+    private: size_t                   _size;
+    private: uint64_t                 _readIndex;
+    private: uint64_t                 _lostCount;
+};
+
+static_assert(sizeof(SharedEventRecord) == 12, "SharedEventRecord has an unexpected size");
+
+#endif
@@ -0,0 +1,83 @@
+/*******************************************************************************
+Implementation file for the StateTable class.
+*******************************************************************************/
+#define DEBUG 0
+
+#include <Arduino.h>
+#include <RTL_Stdlib.h>
+#include "StateTable.h"
+
+
+DEFINE_CLASSNAME(StateTable);
+
+
+StateTable::StateTable(const EVENT_ID* events, uint8_t eventCount,
+                       const StateTransition* table, uint8_t stateCount,
+                       uint8_t initialState)
+{
+    _events       = events;
+    _eventCount   = eventCount;
+    _table        = table;
+    _stateCount   = stateCount;
+    _currentState = initialState;
+}
+
+
+//******************************************************************************
+// Looks up the transition for the event in the current state, executes its
+// action and moves to the next state.
+//******************************************************************************
+void StateTable::OnEvent(const Event* pEvent)
+{
+    auto column = FindEvent(pEvent->EventID);
+
+    if (column < 0) return;
+
+    // Copy the cell out of flash
+    StateTransition transition;
+
+    memcpy_P(&transition, &_table[_currentState * _eventCount + column], sizeof(transition));
+
+    TRACE(Logger(_classname_, this) << F("OnEvent: ID=") << _HEX(pEvent->EventID) << F(", state=") << _currentState << F(", next=") << transition.NextState << endl);
+
+    if (transition.Action != nullptr) (*transition.Action)(pEvent);
+
+    if (transition.NextState != NoChange) SetState(transition.NextState);
+}
+
+
+//******************************************************************************
+// Moves the machine to a new state
+//******************************************************************************
+void StateTable::SetState(uint8_t newState)
+{
+    if (newState == _currentState || newState >= _stateCount) return;
+
+    auto oldState = _currentState;
+
+    _currentState = newState;
+
+    StateTransitioned(oldState, newState);
+}
+
+
+//******************************************************************************
+// Binary search of the (sorted) event array in flash.
+//******************************************************************************
+int16_t StateTable::FindEvent(EVENT_ID eventID)
+{
+    int16_t lo = 0;
+    int16_t hi = _eventCount - 1;
+
+    while (lo <= hi)
+    {
+        int16_t mid = (lo + hi) >> 1;
+        EVENT_ID id = pgm_read_word(&_events[mid]);
+
+        if (id == eventID) return mid;
+
+        if (id < eventID) lo = mid + 1; else hi = mid - 1;
+    }
+
+    return -1;
+}
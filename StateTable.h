@@ -0,0 +1,160 @@
+#pragma once
+/*******************************************************************************
+Header file for the StateTable class.
+*******************************************************************************/
+
+#include <RTL_StdLib.h>
+#include "Event.h"
+#include "StateBase.h"
+
+
+/// Signature of an action executed when a state table transition fires.
+typedef void (*STATE_ACTION)(const Event* pEvent);
+
+
+//******************************************************************************
+/// A single cell in a state transition table: the state to move to and the
+/// action to execute when an event is received in a given state.
+//******************************************************************************
+struct StateTransition      /* Size = 3 bytes (16 bit) or 5 bytes (32 bit) */
+{
+    uint8_t      NextState;     // StateTable::NoChange to remain in the current state
+    STATE_ACTION Action;        // nullptr for no action
+};
+
+
+/// A table cell that ignores the event.
+#define NO_TRANSITION { StateTable::NoChange, nullptr }
+
+/// Validates a state table at compile time. Both the event list and the table
+/// must be declared constexpr.
+#define STATE_TABLE_ASSERT(events, table) \
+    static_assert(StateTable::IsSorted(events), #events " must be sorted in ascending order with no duplicates"); \
+    static_assert(StateTable::IsValid(table), #table " contains a transition to an undefined state")
+
+
+//******************************************************************************
+/// A table driven state machine.
+///
+/// Rather than implementing transitions imperatively in an OnEvent() override,
+/// the machine is described by two constant arrays that can be placed in flash
+/// (PROGMEM on AVR):
+///
+///   - an array of the EVENT_IDs the machine responds to, sorted ascending, and
+///   - a [state][event] array of StateTransition cells, where the column index
+///     is the position of the event in the event array.
+///
+/// StateTable is itself a StateBase, so it is activated with
+/// TaskManager::SetCurrentState() and is driven by the normal TaskManager
+/// dispatch loop. Each event is handled by locating its column in the event
+/// array (binary search) and reading a single cell from the table, so there is
+/// no per-state virtual call or branching. Events not in the event array are
+/// ignored. The machine's state is a small integer, typically an enum value.
+///
+/// Example:
+///
+///     enum RobotState { Idle, Driving, Avoiding, STATE_COUNT };
+///
+///     static constexpr EVENT_ID RobotEvents[] PROGMEM =       // sorted
+///     {
+///         EventSourceID::SonarSensor | EventCode::Obstacle,
+///         EventSourceID::Movement    | EventCode::TurnEnd,
+///         TaskCompleteEvent,
+///     };
+///
+///     static constexpr StateTransition RobotTable[STATE_COUNT][3] PROGMEM =
+///     {
+///         /* Idle     */ { NO_TRANSITION,       NO_TRANSITION,         { Driving, StartDrive } },
+///         /* Driving  */ { { Avoiding, Turn },  NO_TRANSITION,         { Idle, nullptr } },
+///         /* Avoiding */ { NO_TRANSITION,       { Driving, nullptr },  NO_TRANSITION },
+///     };
+///
+///     STATE_TABLE_ASSERT(RobotEvents, RobotTable);
+///
+///     StateTable Robot(RobotEvents, RobotTable, Idle);
+///
+/// ============================================================================
+/// IMPORTANT: The event array *MUST* be sorted in ascending order.
+//******************************************************************************
+class StateTable : public StateBase     /* Size = 16 bytes (16 bit) */
+{
+    DECLARE_CLASSNAME;
+
+    /*--------------------------------------------------------------------------
+    Constants
+    --------------------------------------------------------------------------*/
+    /// The NextState value that leaves the machine in its current state.
+    public: static const uint8_t NoChange = 0xFF;
+
+    /*--------------------------------------------------------------------------
+    Constructors
+    --------------------------------------------------------------------------*/
+    public: StateTable(const EVENT_ID* events, uint8_t eventCount,
+                       const StateTransition* table, uint8_t stateCount,
+                       uint8_t initialState = 0);
+
+    public: template<uint8_t STATES, uint8_t EVENTS>
+            StateTable(const EVENT_ID (&events)[EVENTS],
+                       const StateTransition (&table)[STATES][EVENTS],
+                       uint8_t initialState = 0)
+            : StateTable(events, EVENTS, &table[0][0], STATES, initialState) { };
+
+    /*--------------------------------------------------------------------------
+    Public interface
+    --------------------------------------------------------------------------*/
+    //**************************************************************************
+    /// Returns the current state of the machine.
+    //**************************************************************************
+    public: uint8_t CurrentState() { return _currentState; };
+
+    //**************************************************************************
+    /// Forces the machine into the specified state without executing an action.
+    //**************************************************************************
+    public: void SetState(uint8_t newState);
+
+    //**************************************************************************
+    /// Notified after the machine has moved from one state to another. Derived
+    /// classes can override this to, for example, switch task lists.
+    //**************************************************************************
+    public: virtual void StateTransitioned(uint8_t oldState, uint8_t newState) { };
+
+    //**************************************************************************
+    /// Compile time validation helpers (see STATE_TABLE_ASSERT). They check the
+    /// range [first, last) by halves so the recursion depth is logarithmic in
+    /// the table size and large tables stay within the constexpr depth limit.
+    //**************************************************************************
+    public: template<uint8_t EVENTS>
+            static constexpr bool IsSorted(const EVENT_ID (&events)[EVENTS], uint16_t first = 1, uint16_t last = EVENTS)
+    {
+        return (last <= first) ? true
+             : (last - first == 1) ? (events[first - 1] < events[first])
+             : (IsSorted(events, first, first + (last - first) / 2) && IsSorted(events, first + (last - first) / 2, last));
+    };
+
+    public: template<uint8_t STATES, uint8_t EVENTS>
+            static constexpr bool IsValid(const StateTransition (&table)[STATES][EVENTS], uint16_t first = 0, uint16_t last = STATES * EVENTS)
+    {
+        return (last <= first) ? true
+             : (last - first == 1) ? (table[first / EVENTS][first % EVENTS].NextState < STATES || table[first / EVENTS][first % EVENTS].NextState == NoChange)
+             : (IsValid(table, first, first + (last - first) / 2) && IsValid(table, first + (last - first) / 2, last));
+    };
+
+    /*--------------------------------------------------------------------------
+    Overrides
+    --------------------------------------------------------------------------*/
+    public: void OnEvent(const Event* pEvent) override;
+
+    public: const __FlashStringHelper* Name() override { return F("StateTable"); };
+
+    /*--------------------------------------------------------------------------
+    Internal implementation
+    --------------------------------------------------------------------------*/
+    /// Returns the column index of an event, or -1 if the event is not handled.
+    private: int16_t FindEvent(EVENT_ID eventID);
+
+    private: const EVENT_ID*        _events;        // In flash
+    private: const StateTransition* _table;         // In flash
+    private: uint8_t                _eventCount;
+    private: uint8_t                _stateCount;
+    private: uint8_t                _currentState;
+};
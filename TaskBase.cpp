@@ -1,16 +1,47 @@
 #include "TaskBase.h"
 #include "RTL_TaskManager.h"
+#include "TaskClock.h"
 
 
 TaskBase::TaskBase(TaskState startingState)
 {
     _taskState = startingState;
+#if TASKSCHEDULER_DATAFLOW
+    _producers = nullptr;
+    _outputVersion = 0;
+    _inputVersion = 0;
+    _inputsStale = true;
+#endif
+#if TASKSCHEDULER_BACKOFF
+    _backoffLevel = 0;
+    _nextPollTime = 0;
+#endif
+#if TASKSCHEDULER_SIGNALS
+    _nextReady = nullptr;
+    _isSignaled = false;
+#endif
+    _listMark = false;
 }
 
 
 bool TaskBase::Run()
 {
-    if (_taskState == Running) return (Poll(), true);
+    if (_taskState == Running)
+    {
+#if TASKSCHEDULER_BACKOFF
+        if (IsBackedOff()) return false;
+#endif
+#if TASKSCHEDULER_DATAFLOW
+        if (!InputsChanged()) return false;
+#endif
+#if TASKSCHEDULER_BACKOFF
+        UpdateBackoff(PollWork());
+#else
+        PollWork();
+#endif
+        return true;
+    }
+
     if (_taskState == Resuming) return (Resume(), true);
 
     return false;
@@ -32,4 +63,138 @@ void TaskBase::Resume()
 
     StateChanging(Resuming);
     _taskState = Running;
+
+#if TASKSCHEDULER_DATAFLOW
+    // Always run once after resuming since inputs may have changed while suspended
+    _inputsStale = true;
+#endif
+#if TASKSCHEDULER_BACKOFF
+    _backoffLevel = 0;
+#endif
+}
+
+
+//******************************************************************************
+// Applies the same checks as Run(), but leaves the input version alone so the
+// task still runs when a producer has changed.
+//******************************************************************************
+bool TaskBase::IsDue()
+{
+    if (_taskState == Resuming) return true;
+    if (_taskState != Running) return false;
+
+#if TASKSCHEDULER_BACKOFF
+    if (IsBackedOff()) return false;
+#endif
+#if TASKSCHEDULER_DATAFLOW
+    if (!InputsChanged(false)) return false;
+#endif
+
+    return true;
+}
+
+
+bool TaskBase::ShouldYield()
+{
+    return TaskManager::IsPassBudgetSpent();
+}
+
+
+#if TASKSCHEDULER_DATAFLOW
+volatile uint32_t TaskBase::_dirtyGeneration = 0;
+
+
+//******************************************************************************
+// Stamps the task's output with a new dirty generation, which is later than
+// the generation at any consumer's last check.
+//******************************************************************************
+void TaskBase::MarkDirty()
+{
+    noInterrupts(); // ATOMIC BLOCK BEGIN
+
+    _outputVersion = ++_dirtyGeneration;
+
+    interrupts();   // ATOMIC BLOCK END
+}
+
+
+//******************************************************************************
+// Compares each producer's stamp with the generation at the last check, so a
+// change is only missed after 2^31 MarkDirty() calls between two checks.
+//******************************************************************************
+bool TaskBase::InputsChanged(bool consume)
+{
+    if (_producers == nullptr) return true;
+
+    noInterrupts(); // ATOMIC BLOCK BEGIN
+
+    bool changed = _inputsStale;
+
+    for (auto p = _producers; *p && !changed; p++)
+    {
+        changed = (int32_t)((*p)->_outputVersion - _inputVersion) > 0;
+    }
+
+    if (consume)
+    {
+        _inputVersion = _dirtyGeneration;
+        _inputsStale = false;
+    }
+
+    interrupts();   // ATOMIC BLOCK END
+
+    return changed;
+}
+#endif
+
+
+#if TASKSCHEDULER_BACKOFF
+bool TaskBase::IsBackedOff()
+{
+    if (_backoffLevel == 0) return false;
+
+    auto untilPoll = (int16_t)(_nextPollTime - (uint16_t)TaskClock::Millis());
+
+    if (untilPoll <= 0) return false;
+
+    // Let the idle wait know when this task needs to run again
+    TaskClock::WakeAt(TaskClock::Millis() + untilPoll);
+
+    return true;
+}
+
+
+//******************************************************************************
+// Doubles the polling interval after each consecutive idle poll (1, 2, 4, ...
+// ms) and snaps back to full rate as soon as the task does work. A Wake() from
+// an ISR while the task was polled restarts the backoff at 1 ms.
+//******************************************************************************
+void TaskBase::UpdateBackoff(bool didWork)
+{
+    noInterrupts(); // ATOMIC BLOCK BEGIN
+
+    if (didWork) _backoffLevel = 0;
+    else if (_backoffLevel <= TASK_MAX_BACKOFF_SHIFT) _backoffLevel = _backoffLevel + 1;
+
+    uint8_t level = _backoffLevel;
+
+    interrupts();   // ATOMIC BLOCK END
+
+    if (level == 0) return;
+
+    auto now = TaskClock::Millis();
+    auto interval = (uint16_t)1 << (level - 1);
+
+    _nextPollTime = (uint16_t)now + interval;
+
+    TaskClock::WakeAt(now + interval);
+}
+#endif
+
+
+#if TASKSCHEDULER_SIGNALS
+void TaskBase::Signal()
+{
+    TaskManager::Signal(*this);
 }
+#endif
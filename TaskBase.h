@@ -4,6 +4,9 @@ Header file for the TaskBase class.
 *******************************************************************************/
 
 #include <RTL_StdLib.h>
+#include "TaskSchedulerConfig.h"
+
+struct TaskSchedule;
 
 
 enum TaskState
@@ -24,8 +27,28 @@ enum TaskState
 /// task queue. As such, the Poll() method should be designed so that it executes
 /// only a small unit of work on each iteration. In addition, it should be designed
 /// to "fail fast" so that task exits as quickly as possible if it has no work to do.
+///
+/// A task can consume the output of other tasks by declaring them as its
+/// producers with DependsOn(). A producer calls MarkDirty() whenever its output
+/// changes. The TaskManager orders the task list so that producers run before
+/// their consumers, and a consumer's Poll() is skipped until at least one of
+/// its producers has been marked dirty since the consumer last ran.
+///
+/// A task that often has nothing to do can override PollWork() instead of
+/// Poll() and return whether it did useful work. Each consecutive idle report
+/// doubles the time until the task is polled again, up to a maximum; doing
+/// work, or a call to Wake(), restores full rate polling. The current state is
+/// woken whenever an event is delivered to it, but a task that receives events
+/// through a listener binding must call Wake() (or Signal()) itself.
+///
+/// A task with more work than fits in one pass can split it up by returning
+/// from Poll() when ShouldYield() reports that the pass's time budget is spent.
+///
+/// Signal() tells the TaskManager that a task has work to do (for example,
+/// from an event binding or an ISR). When the TaskManager is in SignaledOnly
+/// dispatch mode, tasks are not polled at all unless they have been signaled.
 //******************************************************************************
-class TaskBase                         /* Size = 4 bytes */
+class TaskBase                         /* Size = 5 bytes (compact = 3 bytes) plus optional features */
 {
     friend class TaskManager;
 
@@ -45,6 +68,14 @@ class TaskBase                         /* Size = 4 bytes */
     //**************************************************************************
     public: virtual void Poll() {};
 
+    //**************************************************************************
+    /// A variant of Poll() that returns true if the task did useful work or
+    /// false if it was idle. Tasks that report idle are polled with an
+    /// exponential backoff. The default implementation calls Poll() and
+    /// returns true, so the task is polled on every pass.
+    //**************************************************************************
+    public: virtual bool PollWork() { Poll(); return true; };
+
     //**************************************************************************
     /// <summary>
     /// Notified when a task is changing state.
@@ -92,6 +123,73 @@ class TaskBase                         /* Size = 4 bytes */
     //**************************************************************************
     public: bool IsRunning() { return _taskState == TaskState::Running; };
 
+#if TASKSCHEDULER_DATAFLOW
+    //**************************************************************************
+    /// Declares the tasks whose output this task consumes. Once set, Poll() is
+    /// only called when a producer has been marked dirty since the last call,
+    /// or when the task has been signaled (see Signal()) or has resumed.
+    /// Passing nullptr makes the task poll unconditionally again.
+    ///
+    /// IMPORTANT: The producer list *MUST* be terminiated with a null entry to
+    ///            mark the end of the list.
+    //**************************************************************************
+    public: void DependsOn(TaskBase* producers[]) { _producers = producers; _inputsStale = true; };
+
+    //**************************************************************************
+    /// Signals that the task's output has changed so that its consumers run on
+    /// their next turn. Can be called from an ISR.
+    //**************************************************************************
+    public: void MarkDirty();
+
+    //**************************************************************************
+    /// Returns the producers of this task (or nullptr if it has none).
+    //**************************************************************************
+    public: TaskBase** Producers() { return _producers; };
+
+    //**************************************************************************
+    /// Makes the task run on its next turn even if none of its producers has
+    /// changed (e.g., because it has unfinished work of its own).
+    //**************************************************************************
+    protected: void MarkInputsStale() { _inputsStale = true; };
+#endif
+
+#if TASKSCHEDULER_BACKOFF
+    //**************************************************************************
+    /// Cancels any polling backoff so the task is polled on the next pass.
+    /// Can be called from an ISR.
+    //**************************************************************************
+    public: void Wake() { _backoffLevel = 0; };
+#endif
+
+#if TASKSCHEDULER_SIGNALS
+    //**************************************************************************
+    /// Signals that the task has work to do. In SignaledOnly dispatch mode the
+    /// task is placed on the TaskManager's ready queue and runs once on the
+    /// next pass; otherwise its polling backoff is cancelled. Either way, a
+    /// task with producers runs on its next turn even if none of them has
+    /// changed. A task that is signaled several times before it runs only
+    /// runs once. Can be called from an ISR.
+    //**************************************************************************
+    public: void Signal();
+#endif
+
+#if TASKSCHEDULER_EDF
+    //**************************************************************************
+    /// Returns the task's periodic schedule for the EarliestDeadline dispatch
+    /// mode, or nullptr if the task is not periodic (see PeriodicTask).
+    //**************************************************************************
+    public: virtual TaskSchedule* Schedule() { return nullptr; };
+#endif
+
+    //**************************************************************************
+    /// Determines if the task should return from Poll() because the current
+    /// TaskManager pass has used up its time budget (see
+    /// TaskManager::SetPassBudget()). A task with more work than fits in one
+    /// pass can check this between units of work and continue on the next pass
+    /// (see ContinuationTask).
+    //**************************************************************************
+    public: static bool ShouldYield();
+
     //**************************************************************************
     /// Returns the name of the task (i.e., the class name).
     //**************************************************************************
@@ -100,6 +198,75 @@ class TaskBase                         /* Size = 4 bytes */
     /*--------------------------------------------------------------------------
      Internal implementation
     --------------------------------------------------------------------------*/
+    /// Determines if Run() would poll (or resume) the task now, without
+    /// changing its state. Used by the TaskManager before the idle wait.
+    private: bool IsDue();
+
+#if TASKSCHEDULER_DATAFLOW
+    /// Determines if any producer has been marked dirty since the task last
+    /// checked and, if consume is true, records the current dirty generation.
+    private: bool InputsChanged(bool consume = true);
+
+    /// Null terminated list of the tasks this task consumes (or nullptr)
+    private: TaskBase** _producers;
+
+    /// Incremented by every MarkDirty() call on any task
+    private: static volatile uint32_t _dirtyGeneration;
+
+    /// The dirty generation when this task's output was last marked dirty
+    private: volatile uint32_t _outputVersion;
+
+    /// The dirty generation when this task last checked its producers
+    private: uint32_t _inputVersion;
+
+    /// Forces the next run regardless of the input version (e.g., after resuming
+    /// or being signaled, which can happen in an ISR)
+    private: volatile bool _inputsStale;
+#endif
+
+#if TASKSCHEDULER_BACKOFF
+    /// Determines if the task is backed off and should not be polled yet
+    private: bool IsBackedOff();
+
+    /// Updates the backoff after the task was polled
+    private: void UpdateBackoff(bool didWork);
+
+    /// The time (low 16 bits of ms) before which the task is not polled
+    private: uint16_t _nextPollTime;
+
+    /// Consecutive idle polls (0 = full rate). Wake() can clear it from an ISR,
+    /// so it has a byte of its own and is only incremented atomically.
+    private: volatile uint8_t _backoffLevel;
+#endif
+
+#if TASKSCHEDULER_SIGNALS
+    /// The next task in the TaskManager's ready queue
+    private: TaskBase* _nextReady;
+
+    /// In the ready queue. Signal() sets it from an ISR, so it must never share
+    /// a byte with the fields below, which are written without disabling
+    /// interrupts.
+    private: volatile bool _isSignaled;
+#endif
+
     /// The current task state
+#if TASKSCHEDULER_COMPACT
+    private: uint8_t _taskState : 2;
+    private: uint8_t _listMark : 1;
+#else
     private: TaskState _taskState;
+    private: bool _listMark;                    // Scratch mark for TaskManager::SetTaskList()
+#endif
 };
+
+static_assert(TASK_MAX_BACKOFF_SHIFT <= 14, "TASK_MAX_BACKOFF_SHIFT must be at most 14");
+
+#if TASKSCHEDULER_COMPACT
+#if defined(__AVR__)
+static_assert(sizeof(TaskBase) == 3 + (TASKSCHEDULER_DATAFLOW ? 11 : 0) + (TASKSCHEDULER_BACKOFF ? 3 : 0) + (TASKSCHEDULER_SIGNALS ? 3 : 0), "Compact TaskBase has an unexpected size");
+#elif !TASKSCHEDULER_DATAFLOW && !TASKSCHEDULER_BACKOFF && !TASKSCHEDULER_SIGNALS
+// Elsewhere only the base layout is checked: the vtable pointer and one byte of
+// state, padded to the pointer alignment
+static_assert(sizeof(TaskBase) == 2 * sizeof(void*), "Compact TaskBase has an unexpected size");
+#endif
+#endif
@@ -0,0 +1,33 @@
+/*******************************************************************************
+Implementation file for the TaskClock class.
+*******************************************************************************/
+#include "TaskClock.h"
+
+#if TASKSCHEDULER_VIRTUAL_CLOCK
+volatile uint32_t TaskClock::_virtualTime = 0;
+bool TaskClock::_isVirtual = false;
+#endif
+
+uint32_t TaskClock::_wakeupTime = 0;
+bool TaskClock::_hasWakeup = false;
+
+
+void TaskClock::WakeAt(uint32_t time)
+{
+    if (!_hasWakeup || (int32_t)(time - _wakeupTime) < 0)
+    {
+        _wakeupTime = time;
+        _hasWakeup = true;
+    }
+}
+
+
+bool TaskClock::TakeWakeup(uint32_t& time)
+{
+    if (!_hasWakeup) return false;
+
+    time = _wakeupTime;
+    _hasWakeup = false;
+
+    return true;
+}
@@ -0,0 +1,88 @@
+#pragma once
+/*******************************************************************************
+Header file for the TaskClock class.
+*******************************************************************************/
+
+#include <Arduino.h>
+#include "TaskSchedulerConfig.h"
+
+
+//******************************************************************************
+/// The time base used by the task scheduler.
+///
+/// Library components read the time with TaskClock::Millis() rather than
+/// calling millis() directly. Normally this is just millis(), but when the
+/// virtual clock is enabled (TASKSCHEDULER_VIRTUAL_CLOCK) the clock can be
+/// switched to a virtual time that only moves when it is explicitly advanced.
+/// This is used by the EventReplayer to replay hours of recorded operation in
+/// seconds: it jumps the clock straight to the next recorded event or the next
+/// deadline rather than waiting in real time. Tasks that want to be replayable
+/// should also use TaskClock::Millis().
+///
+/// Components with deadlines (e.g., timers) report them with WakeAt() on each
+/// pass so that a virtual clock driver knows the next time it must advance to,
+/// and so that TaskManager knows how long it may block in its idle wait.
+//******************************************************************************
+class TaskClock
+{
+    /*--------------------------------------------------------------------------
+    Constructors
+    --------------------------------------------------------------------------*/
+    private: TaskClock() {};
+
+    /*--------------------------------------------------------------------------
+    Public interface
+    --------------------------------------------------------------------------*/
+#if TASKSCHEDULER_VIRTUAL_CLOCK
+    //**************************************************************************
+    /// Returns the current time in milliseconds.
+    //**************************************************************************
+    public: static uint32_t Millis() { return _isVirtual ? _virtualTime : millis(); };
+
+    //**************************************************************************
+    /// Switches to the virtual clock, starting at the specified time.
+    //**************************************************************************
+    public: static void StartVirtual(uint32_t startTime) { _virtualTime = startTime; _isVirtual = true; _hasWakeup = false; };
+
+    //**************************************************************************
+    /// Switches back to the real clock.
+    //**************************************************************************
+    public: static void StopVirtual() { _isVirtual = false; };
+
+    //**************************************************************************
+    /// Indicates if the virtual clock is in use.
+    //**************************************************************************
+    public: static bool IsVirtual() { return _isVirtual; };
+
+    //**************************************************************************
+    /// Advances the virtual clock to the specified time. The clock never moves
+    /// backwards (times are compared modulo 2^32).
+    //**************************************************************************
+    public: static void AdvanceTo(uint32_t time) { if ((int32_t)(time - _virtualTime) > 0) _virtualTime = time; };
+
+#else
+    public: static uint32_t Millis() { return millis(); };
+#endif
+
+    //**************************************************************************
+    /// Reports that something needs to run at the specified time. The earliest
+    /// reported time is retained until it is taken with TakeWakeup().
+    //**************************************************************************
+    public: static void WakeAt(uint32_t time);
+
+    //**************************************************************************
+    /// Retrieves and clears the earliest reported wakeup time. Returns false if
+    /// no wakeup has been reported.
+    //**************************************************************************
+    public: static bool TakeWakeup(uint32_t& time);
+
+    /*--------------------------------------------------------------------------
+    Internal implementation
+    --------------------------------------------------------------------------*/
+#if TASKSCHEDULER_VIRTUAL_CLOCK
+    private: static volatile uint32_t _virtualTime;
+    private: static bool _isVirtual;
+#endif
+    private: static uint32_t _wakeupTime;
+    private: static bool _hasWakeup;
+};
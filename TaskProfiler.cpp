@@ -0,0 +1,201 @@
+/*******************************************************************************
+Implementation file for the TaskProfiler class.
+*******************************************************************************/
+#define DEBUG 0
+
+#include <Arduino.h>
+#include <RTL_Stdlib.h>
+#include "TaskBase.h"
+#include "TaskProfiler.h"
+
+#if defined(__linux__)
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#endif
+
+
+DEFINE_CLASSNAME(TaskProfiler);
+
+volatile uintptr_t TaskProfiler::_current = TaskProfiler::SCHEDULER_KEY;
+volatile uintptr_t TaskProfiler::_keys[PROFILER_SLOTS];
+volatile uint32_t  TaskProfiler::_counts[PROFILER_SLOTS];
+volatile uint32_t  TaskProfiler::_sampleCount = 0;
+volatile uint32_t  TaskProfiler::_droppedCount = 0;
+
+
+#if defined(__AVR__)
+//******************************************************************************
+// Stores the current activity. The two byte store is not atomic on the AVR, so
+// interrupts are disabled to keep Sample() from reading a half written key.
+//******************************************************************************
+void TaskProfiler::Publish(uintptr_t key)
+{
+    noInterrupts(); // ATOMIC BLOCK BEGIN
+    _current = key;
+    interrupts();   // ATOMIC BLOCK END
+}
+#endif
+
+
+//******************************************************************************
+// Counts a sample of the current activity. Runs in interrupt (or signal)
+// context, so it only touches the histogram.
+//******************************************************************************
+void TaskProfiler::Sample()
+{
+    auto key = _current;
+    auto i = (uint16_t)((key >> 1) % PROFILER_SLOTS);
+
+    _sampleCount++;
+
+    for (auto n = 0; n < PROFILER_SLOTS; n++)
+    {
+        if (_counts[i] == 0)
+        {
+            _keys[i] = key;
+            _counts[i] = 1;
+            return;
+        }
+
+        if (_keys[i] == key)
+        {
+            _counts[i]++;
+            return;
+        }
+
+        if (++i == PROFILER_SLOTS) i = 0;
+    }
+
+    _droppedCount++;
+}
+
+
+void TaskProfiler::Reset()
+{
+    noInterrupts(); // ATOMIC BLOCK BEGIN
+
+    for (auto i = 0; i < PROFILER_SLOTS; i++) _counts[i] = 0;
+
+    _sampleCount = 0;
+    _droppedCount = 0;
+
+    interrupts();   // ATOMIC BLOCK END
+}
+
+
+void TaskProfiler::Dump(const __FlashStringHelper* message)
+{
+    uintptr_t keys[PROFILER_SLOTS];
+    uint32_t  counts[PROFILER_SLOTS];
+
+    noInterrupts(); // ATOMIC BLOCK BEGIN
+
+    for (auto i = 0; i < PROFILER_SLOTS; i++)
+    {
+        keys[i] = _keys[i];
+        counts[i] = _counts[i];
+    }
+
+    uint32_t total = _sampleCount;
+
+    interrupts();   // ATOMIC BLOCK END
+
+    Logger(_classname_) << F("Profile - ") << message << F(" (") << total << F(" samples)") << endl;
+
+    if (total == 0) return;
+
+    // Selection sort on output: print the busiest remaining activity each time
+    for (auto rank = 1; ; rank++)
+    {
+        auto busiest = -1;
+
+        for (auto i = 0; i < PROFILER_SLOTS; i++)
+        {
+            if (counts[i] != 0 && (busiest < 0 || counts[i] > counts[busiest])) busiest = i;
+        }
+
+        if (busiest < 0) break;
+
+        auto key = keys[busiest];
+        auto count = counts[busiest];
+        auto percent = (uint16_t)(100.0 * count / total);
+
+        counts[busiest] = 0;
+
+        if (key == SCHEDULER_KEY)
+        {
+            Logger(_classname_) << rank << F(".    Scheduler ") << count << F(" (") << percent << F("%)") << endl;
+        }
+        else if (key == IDLE_WAIT_KEY)
+        {
+            Logger(_classname_) << rank << F(".    Idle wait ") << count << F(" (") << percent << F("%)") << endl;
+        }
+        else if (key & 1)
+        {
+            Logger(_classname_) << rank << F(".    Event ") << _HEX((EVENT_ID)(key >> 1)) << ' ' << count << F(" (") << percent << F("%)") << endl;
+        }
+        else
+        {
+            auto pTask = (TaskBase*)key;
+            Logger(_classname_) << rank << F(".    ") << pTask->Name() << '[' << PTR(pTask) << F("] ") << count << F(" (") << percent << F("%)") << endl;
+        }
+    }
+
+    if (_droppedCount != 0) Logger(_classname_) << F("Dropped: ") << _droppedCount << endl;
+}
+
+
+#if defined(__linux__)
+static timer_t s_timer;
+static bool    s_timerCreated = false;
+
+
+static void OnProfileTimer(int)
+{
+    TaskProfiler::Sample();
+}
+
+
+bool TaskProfiler::Start(uint32_t intervalUs)
+{
+    Stop();
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = &OnProfileTimer;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+
+    if (sigaction(SIGPROF, &action, nullptr) < 0) return false;
+
+    struct sigevent event;
+    memset(&event, 0, sizeof(event));
+    event.sigev_notify = SIGEV_SIGNAL;
+    event.sigev_signo = SIGPROF;
+
+    if (timer_create(CLOCK_MONOTONIC, &event, &s_timer) < 0)
+    {
+        TRACE(Logger(_classname_) << F("Start: timer_create failed") << endl);
+        return false;
+    }
+
+    s_timerCreated = true;
+
+    struct itimerspec spec;
+    spec.it_interval.tv_sec = intervalUs / 1000000;
+    spec.it_interval.tv_nsec = (intervalUs % 1000000) * 1000L;
+    spec.it_value = spec.it_interval;
+
+    return timer_settime(s_timer, 0, &spec, nullptr) == 0;
+}
+
+
+void TaskProfiler::Stop()
+{
+    if (!s_timerCreated) return;
+
+    timer_delete(s_timer);
+    s_timerCreated = false;
+}
+#endif
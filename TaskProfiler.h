@@ -0,0 +1,115 @@
+#pragma once
+/*******************************************************************************
+Header file for the TaskProfiler class.
+*******************************************************************************/
+
+#include <RTL_StdLib.h>
+#include "TaskSchedulerConfig.h"
+#include "Event.h"
+
+class TaskBase;
+
+
+//******************************************************************************
+/// A low overhead sampling profiler for the TaskManager dispatch loop.
+///
+/// TaskManager::Dispatch() publishes what it is currently executing (a task,
+/// the current state, the handling of an event by the current state, or the
+/// idle wait) to a single volatile word. On targets where a word store is not
+/// atomic (the 8 bit AVR stores a pointer one byte at a time) the store is made
+/// with interrupts disabled, so Sample() never sees a torn value. A periodic
+/// interrupt calls Sample(), which adds the published activity to a histogram.
+/// Over many samples the histogram shows how loop time is divided between the
+/// activities, without timing each call.
+///
+/// On the Linux host, Start() samples with a POSIX interval timer (SIGPROF).
+/// The signal ends a blocking idle wait early, and Dispatch() starts another
+/// pass. On a microcontroller, call Sample() from a timer interrupt.
+///
+/// The histogram holds PROFILER_SLOTS distinct activities; samples of further
+/// activities are counted as dropped. Time in Dispatch() outside any task,
+/// state or event handler (e.g., the TimerService), and time outside Dispatch()
+/// altogether, is reported as "Scheduler".
+/// ============================================================================
+/// IMPORTANT: On 16 bit targets, events are identified by the low 15 bits of
+/// their event ID.
+//******************************************************************************
+class TaskProfiler
+{
+    DECLARE_CLASSNAME;
+
+    /*--------------------------------------------------------------------------
+    Constructors
+    --------------------------------------------------------------------------*/
+    private: TaskProfiler() {};
+
+    /*--------------------------------------------------------------------------
+    Public interface
+    --------------------------------------------------------------------------*/
+    //**************************************************************************
+    /// Publishes the current activity. Called by the TaskManager.
+    //**************************************************************************
+    public: static void EnterTask(TaskBase* pTask) { Publish((uintptr_t)pTask); };
+    public: static void EnterEvent(EVENT_ID eventID) { Publish(((uintptr_t)eventID << 1) | 1); };
+    public: static void EnterIdleWait() { Publish(IDLE_WAIT_KEY); };
+    public: static void Leave() { Publish(SCHEDULER_KEY); };
+
+    //**************************************************************************
+    /// Adds the current activity to the histogram. Call from a periodic timer
+    /// interrupt (or signal handler).
+    //**************************************************************************
+    public: static void Sample();
+
+    //**************************************************************************
+    /// Clears the histogram.
+    //**************************************************************************
+    public: static void Reset();
+
+    //**************************************************************************
+    /// Returns the number of samples taken (including dropped samples) and the
+    /// number of samples dropped because the histogram was full.
+    //**************************************************************************
+    public: static uint32_t SampleCount() { return _sampleCount; };
+    public: static uint32_t DroppedCount() { return _droppedCount; };
+
+    //**************************************************************************
+    /// Diagnostic method to display the histogram, busiest activity first.
+    //**************************************************************************
+    public: static void Dump(const __FlashStringHelper* message = nullptr);
+
+#if defined(__linux__)
+    //**************************************************************************
+    /// Starts sampling every intervalUs microseconds with a POSIX interval
+    /// timer. Returns false if the timer could not be created.
+    //**************************************************************************
+    public: static bool Start(uint32_t intervalUs = 1000);
+
+    //**************************************************************************
+    /// Stops sampling.
+    //**************************************************************************
+    public: static void Stop();
+#endif
+
+    /*--------------------------------------------------------------------------
+    Internal implementation
+    --------------------------------------------------------------------------*/
+    /// Activity keys: task and state pointers are even, events are odd
+    private: static const uintptr_t SCHEDULER_KEY = 0;
+    private: static const uintptr_t IDLE_WAIT_KEY = 2;
+
+    /// The current activity
+    private: static volatile uintptr_t _current;
+
+    /// Stores the current activity atomically with respect to Sample()
+#if defined(__AVR__)
+    private: static void Publish(uintptr_t key);
+#else
+    private: static void Publish(uintptr_t key) { _current = key; };
+#endif
+
+    /// The histogram, an open addressed hash table (a count of 0 marks a free slot)
+    private: static volatile uintptr_t _keys[PROFILER_SLOTS];
+    private: static volatile uint32_t  _counts[PROFILER_SLOTS];
+    private: static volatile uint32_t  _sampleCount;
+    private: static volatile uint32_t  _droppedCount;
+};
@@ -0,0 +1,214 @@
+#ifndef _TaskSchedulerConfig_h_
+#define _TaskSchedulerConfig_h_
+/*******************************************************************************
+Compile time configuration for the RTL_TaskScheduler library.
+
+Each setting can be overridden by defining it (e.g., with a -D compiler flag)
+before any library header is included.
+*******************************************************************************/
+
+/*******************************************************************************
+TASKSCHEDULER_COMPACT
+
+When non-zero, the library is built with a compact memory profile for targets
+where SRAM is the tightest constraint (e.g., ATmega328):
+
+  - TaskBase packs its state into a bitfield,
+  - Event carries a 2 byte payload (Int, UnsignedInt, Bool) instead of a 4 byte
+    variant, so float and 32 bit payloads are not available, and
+  - Event refers to its source by an 8 bit index (see EVENT_SOURCE_MAX) instead
+    of an EventSource pointer. Use Event::GetSource() to access the source in a
+    way that works in both profiles.
+*******************************************************************************/
+#ifndef TASKSCHEDULER_COMPACT
+#define TASKSCHEDULER_COMPACT 0
+#endif
+
+/*******************************************************************************
+Optional per-task features
+
+Each of these adds RAM to every task, so they are off by default on AVR and in
+the compact profile, where TaskBase stays at 5 bytes (3 bytes compact). With
+all three on, an AVR TaskBase grows to 22 bytes. The costs given are for AVR;
+alignment makes them larger on 32 and 64 bit targets.
+*******************************************************************************/
+
+/// When non-zero, tasks can declare producer/consumer dependencies on other
+/// tasks (see TaskBase::DependsOn()). Costs 11 bytes per task.
+#ifndef TASKSCHEDULER_DATAFLOW
+#if defined(__AVR__)
+#define TASKSCHEDULER_DATAFLOW 0
+#else
+#define TASKSCHEDULER_DATAFLOW !TASKSCHEDULER_COMPACT
+#endif
+#endif
+
+/// When non-zero, tasks that report idle from PollWork() are polled with an
+/// exponential backoff of up to 2^TASK_MAX_BACKOFF_SHIFT ms (max 14). Costs
+/// 3 bytes per task.
+#ifndef TASKSCHEDULER_BACKOFF
+#if defined(__AVR__)
+#define TASKSCHEDULER_BACKOFF 0
+#else
+#define TASKSCHEDULER_BACKOFF !TASKSCHEDULER_COMPACT
+#endif
+#endif
+
+#ifndef TASK_MAX_BACKOFF_SHIFT
+#define TASK_MAX_BACKOFF_SHIFT 7
+#endif
+
+/// When non-zero, tasks can be signaled to run (see TaskBase::Signal()) and
+/// TaskManager supports the SignaledOnly dispatch mode. Costs 3 bytes per
+/// task.
+#ifndef TASKSCHEDULER_SIGNALS
+#if defined(__AVR__)
+#define TASKSCHEDULER_SIGNALS 0
+#else
+#define TASKSCHEDULER_SIGNALS !TASKSCHEDULER_COMPACT
+#endif
+#endif
+
+/// When non-zero, EventSources can be debounced and rate limited with an
+/// EventThrottle. Costs 2 bytes per EventSource (16 bit).
+#ifndef TASKSCHEDULER_EVENT_THROTTLE
+#define TASKSCHEDULER_EVENT_THROTTLE 1
+#endif
+
+/// When non-zero, TaskClock supports a virtual clock for deterministic replay.
+/// Enabled by default on the Linux host only.
+#ifndef TASKSCHEDULER_VIRTUAL_CLOCK
+#if defined(__linux__)
+#define TASKSCHEDULER_VIRTUAL_CLOCK 1
+#else
+#define TASKSCHEDULER_VIRTUAL_CLOCK 0
+#endif
+#endif
+
+/// When non-zero, TaskManager::Dispatch() services the TimerService timing
+/// wheel. The wheel has TIMER_WHEEL_LEVELS levels of 2^TIMER_WHEEL_BITS slots
+/// with a 1 ms tick; delays beyond the wheel's range are re-cascaded.
+/// Disabled by default on AVR, where the wheel takes about 100 bytes of SRAM.
+#ifndef TASKSCHEDULER_TIMERS
+#if defined(__AVR__)
+#define TASKSCHEDULER_TIMERS 0
+#else
+#define TASKSCHEDULER_TIMERS 1
+#endif
+#endif
+
+#ifndef TIMER_WHEEL_BITS
+#if defined(__AVR__)
+#define TIMER_WHEEL_BITS 4          // 3 x 16 slots = 96 bytes, 4 s range
+#else
+#define TIMER_WHEEL_BITS 6          // 4 x 64 slots, 4.6 hour range
+#endif
+#endif
+
+#ifndef TIMER_WHEEL_LEVELS
+#if defined(__AVR__)
+#define TIMER_WHEEL_LEVELS 3
+#else
+#define TIMER_WHEEL_LEVELS 4
+#endif
+#endif
+
+/// When non-zero, TaskManager supports the EarliestDeadline dispatch mode for
+/// PeriodicTasks.
+#ifndef TASKSCHEDULER_EDF
+#define TASKSCHEDULER_EDF 1
+#endif
+
+/// When non-zero, TaskManager::Dispatch() completes requests tracked by the
+/// RequestTracker when their responses arrive and expires them when they time
+/// out. Up to REQUEST_SLOTS requests (max 255) can be outstanding at a time.
+/// Disabled by default on AVR, where the slots take 14 bytes each (about 112
+/// bytes of SRAM); enable it with fewer REQUEST_SLOTS if needed.
+#ifndef TASKSCHEDULER_REQUESTS
+#if defined(__AVR__)
+#define TASKSCHEDULER_REQUESTS 0
+#else
+#define TASKSCHEDULER_REQUESTS 1
+#endif
+#endif
+
+#ifndef REQUEST_SLOTS
+#if defined(__AVR__)
+#define REQUEST_SLOTS 4
+#else
+#define REQUEST_SLOTS 8
+#endif
+#endif
+
+/// When non-zero, TaskManager::Dispatch() publishes what it is executing for
+/// the TaskProfiler, which keeps a histogram of PROFILER_SLOTS entries.
+/// Enabled by default on the Linux host only.
+#ifndef TASKSCHEDULER_PROFILER
+#if defined(__linux__)
+#define TASKSCHEDULER_PROFILER 1
+#else
+#define TASKSCHEDULER_PROFILER 0
+#endif
+#endif
+
+#ifndef PROFILER_SLOTS
+#define PROFILER_SLOTS 32
+#endif
+
+/// When non-zero, TaskManager::Dispatch() keeps SchedulerMetrics: the time
+/// spent in each phase of a pass, a histogram of the loop period with
+/// METRICS_HISTOGRAM_BINS bins (the first bin holds periods shorter than
+/// METRICS_HISTOGRAM_BASE_US and each further bin doubles the limit), and the
+/// number of events dispatched per pass. Disabled by default on AVR, where the
+/// counters take about 150 bytes of SRAM.
+#ifndef TASKSCHEDULER_METRICS
+#if defined(__AVR__)
+#define TASKSCHEDULER_METRICS 0
+#else
+#define TASKSCHEDULER_METRICS 1
+#endif
+#endif
+
+#ifndef METRICS_HISTOGRAM_BINS
+#if defined(__AVR__)
+#define METRICS_HISTOGRAM_BINS 8
+#else
+#define METRICS_HISTOGRAM_BINS 12
+#endif
+#endif
+
+#ifndef METRICS_HISTOGRAM_BASE_US
+#define METRICS_HISTOGRAM_BASE_US 64
+#endif
+
+/// The number of events the EventQueue can hold (max 127).
+#ifndef EVENT_QUEUE_SIZE
+#define EVENT_QUEUE_SIZE 8
+#endif
+
+/// The number of event priority levels (1 to 4, see EventPriority).
+#ifndef EVENT_PRIORITY_LEVELS
+#define EVENT_PRIORITY_LEVELS 4
+#endif
+
+/// The maximum number of EventSources that can be indexed in the compact
+/// profile (max 31). Index 0 is reserved to mean "no source".
+#ifndef EVENT_SOURCE_MAX
+#define EVENT_SOURCE_MAX 16
+#endif
+
+/// The maximum number of events in one EventBridge frame (max 127).
+#ifndef EVENT_BRIDGE_BATCH
+#if defined(__AVR__)
+#define EVENT_BRIDGE_BATCH 8
+#else
+#define EVENT_BRIDGE_BATCH 32
+#endif
+#endif
+
+/// The number of sources an EventBridge can map to source ids.
+#ifndef EVENT_BRIDGE_SOURCES
+#define EVENT_BRIDGE_SOURCES 8
+#endif
+
+#endif
@@ -0,0 +1,313 @@
+/*******************************************************************************
+Implementation file for the Timer and TimerService classes.
+*******************************************************************************/
+#define DEBUG 0
+
+#include <Arduino.h>
+#include <RTL_Stdlib.h>
+#include "TimerService.h"
+#include "TaskClock.h"
+
+#if TASKSCHEDULER_TIMERS
+
+/*******************************************************************************
+Timer
+*******************************************************************************/
+
+Timer::Timer(EVENT_ID eventID)
+{
+    _next    = nullptr;
+    _prev    = nullptr;
+    _expires = 0;
+    _period  = 0;
+    _eventID = eventID;
+    _slot    = INACTIVE;
+}
+
+
+Timer::~Timer()
+{
+    TimerService::Cancel(*this);
+}
+
+
+void Timer::Start(uint32_t delay, uint32_t period)
+{
+    TimerService::Start(*this, delay, period);
+}
+
+
+void Timer::Cancel()
+{
+    TimerService::Cancel(*this);
+}
+
+
+/*******************************************************************************
+TimerService
+*******************************************************************************/
+
+DEFINE_CLASSNAME(TimerService);
+
+Timer*   TimerService::_wheel[LEVELS << BITS];
+uint32_t TimerService::_tick = 0;
+uint32_t TimerService::_nextTick = 0;
+uint16_t TimerService::_count = 0;
+
+
+//******************************************************************************
+// Starts a timer
+//******************************************************************************
+void TimerService::Start(Timer& timer, uint32_t delay, uint32_t period)
+{
+    auto now = TaskClock::Millis();
+
+    if (timer.IsActive()) Cancel(timer);
+
+    // With no active timers the wheel position may be stale; restart it at now
+    if (_count == 0)
+    {
+        _tick = now;
+        _nextTick = now + ((uint32_t)1 << (BITS * LEVELS));
+    }
+
+    timer._expires = now + delay;
+    timer._period  = period;
+
+    Insert(timer);
+    _count++;
+
+    // Let the idle wait (or a virtual clock driver) know about the new deadline
+    TaskClock::WakeAt(timer._expires);
+
+    TRACE(Logger(_classname_) << F("Start: timer=") << _HEX(PTR(&timer)) << F(", expires=") << timer._expires << endl);
+}
+
+
+//******************************************************************************
+// Cancels a timer. The cached next event tick is left as is; it is still a
+// lower bound, and is recomputed once it is reached.
+//******************************************************************************
+void TimerService::Cancel(Timer& timer)
+{
+    if (!timer.IsActive()) return;
+
+    Unlink(timer);
+    _count--;
+}
+
+
+//******************************************************************************
+// Places a timer in the slot for its expiry time. The level is chosen by how
+// far in the future the timer expires relative to the next tick to process.
+// A slot above level 0 is cascaded at the start of its span, which is never
+// before the next tick to process, so that tick bounds the next event tick.
+//******************************************************************************
+void TimerService::Insert(Timer& timer)
+{
+    static const uint32_t RANGE = (uint32_t)1 << (BITS * LEVELS);
+
+    auto expires = timer._expires;
+    auto delta   = expires - _tick;
+    uint8_t level = 0;
+
+    if ((int32_t)delta < 0)
+    {
+        // Already due; expire on the next tick processed
+        expires = _tick;
+        delta = 0;
+    }
+    else if (delta >= RANGE)
+    {
+        // Beyond the wheel's range; park in the top level and re-cascade later
+        expires = _tick + RANGE - 1;
+        delta = RANGE - 1;
+    }
+
+    while (level < LEVELS - 1 && delta >= ((uint32_t)1 << (BITS * (level + 1)))) level++;
+
+    auto slot = (uint16_t)((level << BITS) | ((expires >> (BITS * level)) & MASK));
+
+    timer._slot = slot;
+    timer._prev = nullptr;
+    timer._next = _wheel[slot];
+
+    if (timer._next != nullptr) timer._next->_prev = &timer;
+
+    _wheel[slot] = &timer;
+
+    auto when = (expires >> (BITS * level)) << (BITS * level);
+
+    if ((int32_t)(when - _nextTick) < 0) _nextTick = when;
+}
+
+
+void TimerService::Unlink(Timer& timer)
+{
+    if (timer._prev != nullptr) timer._prev->_next = timer._next;
+    else _wheel[timer._slot] = timer._next;
+
+    if (timer._next != nullptr) timer._next->_prev = timer._prev;
+
+    timer._next = timer._prev = nullptr;
+    timer._slot = Timer::INACTIVE;
+}
+
+
+//******************************************************************************
+// Moves the timers in the current slot of a level down to lower levels.
+//******************************************************************************
+void TimerService::Cascade(uint8_t level)
+{
+    auto slot = (level << BITS) | ((_tick >> (BITS * level)) & MASK);
+    auto pTimer = _wheel[slot];
+
+    _wheel[slot] = nullptr;
+
+    while (pTimer != nullptr)
+    {
+        auto pNext = pTimer->_next;
+
+        Insert(*pTimer);
+        pTimer = pNext;
+    }
+}
+
+
+//******************************************************************************
+// Processes the tick at _tick: cascades higher levels at level 0 revolution
+// boundaries, then expires the timers in the current level 0 slot.
+//******************************************************************************
+void TimerService::Tick(uint32_t now)
+{
+    auto index = _tick & MASK;
+
+    if (index == 0)
+    {
+        for (uint8_t level = 1; level < LEVELS; level++)
+        {
+            Cascade(level);
+
+            if (((_tick >> (BITS * level)) & MASK) != 0) break;
+        }
+    }
+
+    auto pTimer = _wheel[index];
+
+    _wheel[index] = nullptr;
+    _tick++;
+
+    while (pTimer != nullptr)
+    {
+        auto pNext = pTimer->_next;
+        uint32_t periods = 1;
+
+        pTimer->_next = pTimer->_prev = nullptr;
+        pTimer->_slot = Timer::INACTIVE;
+        _count--;
+
+        if (pTimer->_period != 0)
+        {
+            // Skip any periods that were missed rather than firing repeatedly
+            periods += (now - pTimer->_expires) / pTimer->_period;
+            pTimer->_expires += periods * pTimer->_period;
+
+            Insert(*pTimer);
+            _count++;
+        }
+
+        pTimer->Fire(periods);
+        pTimer = pNext;
+    }
+}
+
+
+//******************************************************************************
+// Returns the earliest tick at which a timer expires (level 0) or a non-empty
+// slot is cascaded (higher levels). This is a lower bound on the next expiry.
+//******************************************************************************
+uint32_t TimerService::NextEventTick()
+{
+    uint32_t next = _tick + ((uint32_t)1 << (BITS * LEVELS));
+
+    for (uint16_t i = 0; i < SLOTS; i++)
+    {
+        if (_wheel[(_tick + i) & MASK] != nullptr)
+        {
+            next = _tick + i;
+            break;
+        }
+    }
+
+    for (uint8_t level = 1; level < LEVELS; level++)
+    {
+        auto shift = BITS * level;
+        auto base  = _tick >> shift;
+
+        // The current slot is cascaded at _tick itself only on a boundary
+        uint16_t first = ((_tick & (((uint32_t)1 << shift) - 1)) == 0) ? 0 : 1;
+
+        for (uint16_t j = first; j < first + SLOTS; j++)
+        {
+            if (_wheel[(level << BITS) | ((base + j) & MASK)] != nullptr)
+            {
+                auto when = (base + j) << shift;
+
+                if ((int32_t)(when - next) < 0) next = when;
+                break;
+            }
+        }
+    }
+
+    return next;
+}
+
+
+//******************************************************************************
+// Processes all ticks up to the current time
+//******************************************************************************
+void TimerService::Poll()
+{
+    auto now = TaskClock::Millis();
+
+    // Nothing expires or cascades before the cached next event tick, so the
+    // ticks up to now are empty and the wheel need not be scanned
+    if (_count > 0 && (int32_t)(_nextTick - now) > 0)
+    {
+        if ((int32_t)(now - _tick) >= 0) _tick = now + 1;
+
+        TaskClock::WakeAt(_nextTick);
+        return;
+    }
+
+    while (_count > 0 && (int32_t)(now - _tick) >= 0)
+    {
+        // When well behind, jump over ticks where nothing can happen
+        if (now - _tick > MASK)
+        {
+            auto next = NextEventTick();
+
+            if ((int32_t)(next - now) > 0)
+            {
+                _tick = now + 1;
+                break;
+            }
+
+            if ((int32_t)(next - _tick) > 0) _tick = next;
+        }
+
+        Tick(now);
+    }
+
+    if (_count == 0)
+    {
+        _tick = now + 1;
+        return;
+    }
+
+    _nextTick = NextEventTick();
+
+    TaskClock::WakeAt(_nextTick);
+}
+
+#endif
@@ -0,0 +1,157 @@
+#pragma once
+/*******************************************************************************
+Header file for the Timer and TimerService classes.
+*******************************************************************************/
+
+#include <RTL_StdLib.h>
+#include "TaskSchedulerConfig.h"
+#include "EventCodes.h"
+#include "EventSource.h"
+
+#if TASKSCHEDULER_TIMERS
+
+//******************************************************************************
+/// A one-shot or periodic timer.
+///
+/// A Timer is an EventSource that queues a TimerFiredEvent (or the EVENT_ID
+/// given to its constructor) each time it expires. The event's source is the
+/// timer and its data is the number of periods that elapsed since the previous
+/// event, which is greater than 1 only if the timer could not be serviced in
+/// time. Listeners can attach to the timer like any other EventSource, and the
+/// event is also delivered to the current state.
+///
+/// Timers are managed by the TimerService. Starting and cancelling a timer are
+/// O(1) operations, and timers do not allocate memory. A timer is cancelled
+/// when it is destroyed, so it can safely go out of scope while active.
+//******************************************************************************
+class Timer : public EventSource        /* Size = 17 bytes (16 bit) */
+{
+    friend class TimerService;
+
+    /*--------------------------------------------------------------------------
+    Constructors
+    --------------------------------------------------------------------------*/
+    public: Timer(EVENT_ID eventID = TimerFiredEvent);
+
+    //**************************************************************************
+    /// Cancels the timer so the TimerService never touches a destroyed timer.
+    //**************************************************************************
+    public: ~Timer();
+
+    /*--------------------------------------------------------------------------
+    Public interface
+    --------------------------------------------------------------------------*/
+    //**************************************************************************
+    /// Starts (or restarts) the timer. The timer expires after delay ms and,
+    /// if period is non-zero, every period ms thereafter.
+    //**************************************************************************
+    public: void Start(uint32_t delay, uint32_t period = 0);
+
+    //**************************************************************************
+    /// Stops the timer. Has no effect if the timer is not active.
+    //**************************************************************************
+    public: void Cancel();
+
+    //**************************************************************************
+    /// Indicates if the timer is active (started and not yet expired or
+    /// cancelled).
+    //**************************************************************************
+    public: bool IsActive() { return _slot != INACTIVE; };
+
+    /*--------------------------------------------------------------------------
+    Internal implementation
+    --------------------------------------------------------------------------*/
+    private: static const uint16_t INACTIVE = 0xFFFF;
+
+    private: void Fire(uint32_t periods) { QueueEvent(_eventID, (int32_t)periods); };
+
+    private: Timer*   _next;            // Links in the wheel slot list
+    private: Timer*   _prev;
+    private: uint32_t _expires;         // Absolute expiry time (ms)
+    private: uint32_t _period;          // Period (ms) or 0 for one-shot
+    private: EVENT_ID _eventID;         // The event queued when the timer fires
+    private: uint16_t _slot;            // The wheel slot the timer is in, or INACTIVE
+};
+
+
+//******************************************************************************
+/// Manages timers with a hierarchical timing wheel.
+///
+/// TimerService is a static singleton. The wheel has TIMER_WHEEL_LEVELS levels
+/// of 2^TIMER_WHEEL_BITS slots each, with a 1 ms tick. Level 0 holds timers
+/// that expire within one revolution of level 0, in the slot for their expiry
+/// tick. Each higher level holds timers that expire further out, in coarser
+/// slots; when a lower level completes a revolution, the next slot of the level
+/// above is cascaded down into it. This makes start and cancel O(1), and the
+/// cost per tick constant regardless of the number of timers (see the
+/// TimerWheelBenchmark example).
+///
+/// Poll() is called by TaskManager::Dispatch() (see TASKSCHEDULER_TIMERS). It
+/// processes every tick elapsed since the previous call, skipping directly over
+/// ticks where nothing can expire, and reports the next time anything can
+/// happen with TaskClock::WakeAt(). That time is cached: starting a timer only
+/// moves it earlier and the wheel is scanned again only once ticks up to it
+/// have been processed, so a Poll() with nothing due does not touch the wheel. Times are compared with unsigned arithmetic
+/// so millis() wraparound is handled; delays must be less than 2^31 ms.
+//******************************************************************************
+class TimerService
+{
+    DECLARE_CLASSNAME;
+
+    friend class Timer;
+
+    /*--------------------------------------------------------------------------
+    Constructors
+    --------------------------------------------------------------------------*/
+    private: TimerService() {};
+
+    /*--------------------------------------------------------------------------
+    Public interface
+    --------------------------------------------------------------------------*/
+    //**************************************************************************
+    /// Expires all timers that are due and queues their events.
+    //**************************************************************************
+    public: static void Poll();
+
+    //**************************************************************************
+    /// Returns the number of active timers.
+    //**************************************************************************
+    public: static uint16_t Count() { return _count; };
+
+    /*--------------------------------------------------------------------------
+    Internal implementation
+    --------------------------------------------------------------------------*/
+    private: static const uint8_t  BITS   = TIMER_WHEEL_BITS;
+    private: static const uint8_t  LEVELS = TIMER_WHEEL_LEVELS;
+    private: static const uint16_t SLOTS  = 1 << BITS;
+    private: static const uint16_t MASK   = SLOTS - 1;
+
+    private: static void Start(Timer& timer, uint32_t delay, uint32_t period);
+
+    private: static void Cancel(Timer& timer);
+
+    /// Places an active timer in the wheel slot for its expiry time
+    private: static void Insert(Timer& timer);
+
+    /// Removes a timer from its wheel slot
+    private: static void Unlink(Timer& timer);
+
+    /// Re-inserts all timers in a slot of the specified level
+    private: static void Cascade(uint8_t level);
+
+    /// Expires the timers in the current level 0 slot and advances one tick
+    private: static void Tick(uint32_t now);
+
+    /// Returns the earliest tick at which a timer can expire or cascade
+    private: static uint32_t NextEventTick();
+
+    private: static Timer*   _wheel[LEVELS << BITS];
+    private: static uint32_t _tick;         // The next tick to process
+    private: static uint32_t _nextTick;     // No timer expires or cascades before this tick
+    private: static uint16_t _count;        // The number of active timers
+};
+
+static_assert(TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS <= 31, "Timer wheel range must be less than 2^31 ms");
+static_assert((TIMER_WHEEL_LEVELS << TIMER_WHEEL_BITS) < 0xFFFF, "Timer wheel has too many slots");
+
+#endif
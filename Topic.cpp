@@ -0,0 +1,80 @@
+/*******************************************************************************
+A latest-value publish/subscribe slot for continuous data.
+*******************************************************************************/
+#define DEBUG 0
+
+#include <Arduino.h>
+#include <string.h>
+#include "Topic.h"
+
+
+/// Orders memory accesses around the sequence lock (a compiler barrier on
+/// single core targets, a full fence on multi-core hosts).
+#define TOPIC_FENCE() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+
+DEFINE_CLASSNAME(TopicBase);
+
+
+void TopicBase::Write(const void* pValue)
+{
+    _lock++;            // Odd: write in progress
+    TOPIC_FENCE();
+
+    memcpy(_pValue, pValue, _size);
+    auto sequence = ++_sequence;
+
+    TOPIC_FENCE();
+    _lock++;            // Even: slot is stable
+
+    if (HasListeners()) DispatchEvent(TopicUpdatedEvent, (long)sequence);
+}
+
+
+bool TopicBase::Read(void* pValue, uint32_t* pSequence)
+{
+    for (auto attempt = 0; attempt < MAX_READ_ATTEMPTS; attempt++)
+    {
+        uint8_t before = _lock;
+
+        if (before & 1) continue;
+
+        TOPIC_FENCE();
+
+        memcpy(pValue, _pValue, _size);
+        auto sequence = _sequence;
+
+        TOPIC_FENCE();
+
+        if (_lock == before)
+        {
+            if (pSequence != nullptr) *pSequence = sequence;
+            return true;
+        }
+    }
+
+    TRACE(Logger(_classname_, this) << F("Read: no stable value") << endl);
+
+    return false;
+}
+
+
+uint32_t TopicBase::Sequence()
+{
+    uint32_t sequence = 0;
+
+    for (auto attempt = 0; attempt < MAX_READ_ATTEMPTS; attempt++)
+    {
+        uint8_t before = _lock;
+
+        if (before & 1) continue;
+
+        TOPIC_FENCE();
+        sequence = _sequence;
+        TOPIC_FENCE();
+
+        if (_lock == before) break;
+    }
+
+    return sequence;
+}
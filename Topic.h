@@ -0,0 +1,112 @@
+#pragma once
+/*******************************************************************************
+Header file for the TopicBase and Topic classes.
+*******************************************************************************/
+
+#include <RTL_StdLib.h>
+#include "EventCodes.h"
+#include "EventSource.h"
+
+
+//******************************************************************************
+/// A latest-value publish/subscribe slot for continuous data (e.g., sensor
+/// readings).
+///
+/// Unlike events, a topic does not queue its values. The producer publishes
+/// each new sample into a single slot, and readers fetch the most recent sample
+/// whenever they need it, together with a sequence number that increases with
+/// every publish. High rate data therefore never occupies EventQueue slots or
+/// costs dispatch calls.
+///
+/// The slot is protected by a sequence lock: the writer makes the lock count
+/// odd while it updates the slot and even when it is done, and a reader retries
+/// its copy if the count was odd or changed during the copy. The writer never
+/// waits for readers. There must be only one writer per topic.
+///
+/// A topic is also an EventSource. If listeners are attached, each publish
+/// dispatches a TopicUpdatedEvent, whose data is the new sequence number,
+/// directly to those listeners in the publisher's context (it does not go
+/// through the EventQueue).
+///
+/// TopicBase implements the type independent logic; use the Topic<T> template.
+/// ============================================================================
+/// IMPORTANT: A reader that interrupts the writer (e.g., reading in an ISR
+/// while main-line code publishes) can never see a stable slot. Read() gives up
+/// after MAX_READ_ATTEMPTS and returns false in that case.
+//******************************************************************************
+class TopicBase : public EventSource
+{
+    DECLARE_CLASSNAME;
+
+    /*--------------------------------------------------------------------------
+    Constants
+    --------------------------------------------------------------------------*/
+    /// The number of times Read() tries to copy the slot before giving up.
+    public: static const uint8_t MAX_READ_ATTEMPTS = 16;
+
+    /*--------------------------------------------------------------------------
+    Constructors
+    --------------------------------------------------------------------------*/
+    protected: TopicBase(void* pValue, uint8_t size) : _pValue(pValue), _size(size), _lock(0), _sequence(0) { };
+
+    /*--------------------------------------------------------------------------
+    Public interface
+    --------------------------------------------------------------------------*/
+    //**************************************************************************
+    /// Returns the number of values published so far (0 if none).
+    //**************************************************************************
+    public: uint32_t Sequence();
+
+    /*--------------------------------------------------------------------------
+    Internal implementation
+    --------------------------------------------------------------------------*/
+    /// Copies a new value into the slot and notifies listeners.
+    protected: void Write(const void* pValue);
+
+    /// Copies the value and its sequence number out of the slot. Returns false
+    /// if a consistent copy could not be made.
+    protected: bool Read(void* pValue, uint32_t* pSequence);
+
+    private: void*            _pValue;      // The slot (owned by Topic<T>)
+    private: uint8_t          _size;        // Size of the slot
+    private: volatile uint8_t _lock;        // Sequence lock count (odd = write in progress)
+    private: uint32_t         _sequence;    // Publish count, protected by _lock
+};
+
+
+//******************************************************************************
+/// A latest-value topic for values of type T, which must be trivially
+/// copyable.
+///
+/// Example:
+///
+///     Topic<ImuSample> Imu;
+///
+///     // Producer
+///     Imu.Publish(sample);
+///
+///     // Consumer
+///     ImuSample latest;
+///     uint32_t  sequence;
+///
+///     if (Imu.Read(latest, &sequence) && sequence != _lastSequence) { ... }
+//******************************************************************************
+template <typename T>
+class Topic : public TopicBase
+{
+    static_assert(sizeof(T) <= 0xFF, "Topic values are limited to 255 bytes");
+
+    public: Topic() : TopicBase(&_value, sizeof(T)), _value() { };
+
+    //**************************************************************************
+    /// Publishes a new value. Must only be called by the topic's one writer.
+    //**************************************************************************
+    public: void Publish(const T& value) { Write(&value); };
+
+    //**************************************************************************
+    /// Reads the latest value and, optionally, its sequence number.
+    //**************************************************************************
+    public: bool Read(T& value, uint32_t* pSequence = nullptr) { return TopicBase::Read(&value, pSequence); };
+
+    private: T _value;
+};
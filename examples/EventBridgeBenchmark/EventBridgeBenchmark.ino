@@ -0,0 +1,151 @@
+/*******************************************************************************
+EventBridgeBenchmark
+
+Measures the throughput of an event bridge and the bytes it sends per event,
+over a pipe and over a pseudo terminal (which behaves like a serial port),
+on the Linux host.
+
+Each round queues a full batch of events from a registered source. Dequeuing
+them forwards them to the writer, which writes a frame. The reader then
+decodes the frame and queues the events again, where they are dequeued and
+checked. So the figures include both ends of the bridge and the EventQueue.
+*******************************************************************************/
+#include <RTL_TaskManager.h>
+#include <EventBridge.h>
+#include <EventQueue.h>
+
+#if !defined(__linux__)
+#error "EventBridgeBenchmark runs on the Linux host"
+#endif
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+static const uint32_t EVENTS = 1000000;
+
+
+//******************************************************************************
+// An EventSource whose events can be queued from the sketch
+//******************************************************************************
+class BenchmarkSource : public EventSource
+{
+    public: bool Queue(EVENT_ID eventID, int16_t data) { return QueueEvent(eventID, data); };
+};
+
+
+//******************************************************************************
+// Sends EVENTS events from writeFd to readFd and prints the results.
+//******************************************************************************
+static void Measure(const __FlashStringHelper* name, int writeFd, int readFd)
+{
+    // A non-blocking input saves an ioctl each time the reader refills its buffer
+    fcntl(readFd, F_SETFL, fcntl(readFd, F_GETFL) | O_NONBLOCK);
+
+    FileDescriptorStream output(writeFd);
+    FileDescriptorStream input(readFd);
+    BenchmarkSource localSource;
+    BenchmarkSource remoteSource;
+
+    EventBridgeWriter writer(output);
+    EventBridgeReader reader(input);
+
+    writer.AddSource(localSource);
+    reader.AddSource(remoteSource);
+    writer.Begin();
+
+    uint32_t sent = 0;
+    uint32_t received = 0;
+    uint32_t errors = 0;
+    Event event;
+
+    auto start = micros();
+
+    while (sent < EVENTS)
+    {
+        // Forward a batch, a queue at a time
+        for (auto batch = 0; batch < EVENT_BRIDGE_BATCH && sent < EVENTS; )
+        {
+            while (batch < EVENT_BRIDGE_BATCH && sent < EVENTS && localSource.Queue(0x0100, (int16_t)sent))
+            {
+                batch++;
+                sent++;
+            }
+
+            while (EventQueue::Dequeue(event));
+        }
+
+        writer.Flush();
+
+        // Receive the batch
+        while (received < sent)
+        {
+            reader.PollWork();
+
+            while (EventQueue::Dequeue(event))
+            {
+                if (event.GetSource() != &remoteSource || event.Data.Int != (int16_t)received) errors++;
+
+                received++;
+            }
+        }
+    }
+
+    auto elapsed = micros() - start;
+
+    writer.End();
+
+    Serial.print(name);
+    Serial.print(F(": "));
+    Serial.print((uint32_t)((uint64_t)EVENTS * 1000000 / elapsed));
+    Serial.print(F(" events/s, "));
+    Serial.print((float)writer.ByteCount() / writer.EventCount());
+    Serial.print(F(" bytes/event, "));
+    Serial.print(writer.FrameCount());
+    Serial.print(F(" frames, "));
+    Serial.print(errors + reader.ErrorCount());
+    Serial.println(F(" errors"));
+}
+
+
+void setup()
+{
+    Serial.begin(115200);
+
+    int pipeFds[2];
+
+    if (pipe(pipeFds) == 0)
+    {
+        Measure(F("pipe"), pipeFds[1], pipeFds[0]);
+
+        close(pipeFds[0]);
+        close(pipeFds[1]);
+    }
+
+    // A raw pseudo terminal, so no bytes are translated
+    auto master = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if (master >= 0 && grantpt(master) == 0 && unlockpt(master) == 0)
+    {
+        auto slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+        termios settings;
+
+        if (slave >= 0 && tcgetattr(slave, &settings) == 0)
+        {
+            cfmakeraw(&settings);
+            tcsetattr(slave, TCSANOW, &settings);
+
+            Measure(F("pty"), master, slave);
+        }
+
+        if (slave >= 0) close(slave);
+    }
+
+    if (master >= 0) close(master);
+}
+
+
+void loop()
+{
+}
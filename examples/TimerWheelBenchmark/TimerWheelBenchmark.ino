@@ -0,0 +1,118 @@
+/*******************************************************************************
+TimerWheelBenchmark
+
+Measures the cost of one TimerService tick as the number of active timers
+grows. A timing wheel processes only the slot for the current tick (plus an
+occasional cascade), so the cost per tick should stay roughly constant from a
+handful of timers to thousands.
+
+The benchmark drives the virtual clock one millisecond at a time, so it needs
+TASKSCHEDULER_VIRTUAL_CLOCK and TASKSCHEDULER_TIMERS (the Linux host defaults).
+Each count is measured twice: with timers started beyond the measured ticks,
+so none of them fires and only the wheel itself is measured, and with
+periodic timers that fire throughout the run. Fired events are dequeued on
+every tick, so the second figure includes queueing them.
+*******************************************************************************/
+#include <RTL_TaskManager.h>
+#include <EventQueue.h>
+#include <TaskClock.h>
+#include <TimerService.h>
+
+#if !TASKSCHEDULER_VIRTUAL_CLOCK || !TASKSCHEDULER_TIMERS
+#error "TimerWheelBenchmark requires TASKSCHEDULER_VIRTUAL_CLOCK and TASKSCHEDULER_TIMERS"
+#endif
+
+static const uint16_t MAX_TIMERS = 4096;
+static const uint32_t TICKS = 100000;
+
+static Timer timers[MAX_TIMERS];
+
+
+//******************************************************************************
+// Returns a pseudo random number (xorshift) so every run uses the same delays
+//******************************************************************************
+static uint32_t NextRandom()
+{
+    static uint32_t state = 2463534242UL;
+
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+
+    return state;
+}
+
+
+//******************************************************************************
+// Starts count timers, advances the clock TICKS ms one tick at a time, and
+// returns the mean cost of a tick in nanoseconds. If firing is true, the
+// timers are periodic and fire during the run; the number of events they
+// queue is added to fired.
+//******************************************************************************
+static uint32_t MeasureTick(uint16_t count, bool firing, uint32_t& fired)
+{
+    auto now = TaskClock::Millis();
+    Event event;
+
+    for (uint16_t i = 0; i < count; i++)
+    {
+        if (firing)
+        {
+            // Periods of 0.1 to 10 s (so every timer fires), starting at random
+            timers[i].Start(1 + NextRandom() % 10000, 100 + NextRandom() % 9900);
+        }
+        else
+        {
+            // Spread the expiry times over the upper levels of the wheel
+            timers[i].Start(TICKS + 1 + NextRandom() % 4000000UL);
+        }
+    }
+
+    auto start = micros();
+
+    for (uint32_t tick = 1; tick <= TICKS; tick++)
+    {
+        TaskClock::AdvanceTo(now + tick);
+        TimerService::Poll();
+
+        while (EventQueue::Dequeue(event)) fired++;
+    }
+
+    auto elapsed = micros() - start;
+
+    for (uint16_t i = 0; i < count; i++) timers[i].Cancel();
+
+    return (uint32_t)((uint64_t)elapsed * 1000 / TICKS);
+}
+
+
+void setup()
+{
+    Serial.begin(115200);
+
+    TaskClock::StartVirtual(0);
+
+    Serial.println(F("Timers  ns/tick (idle)  ns/tick (firing)  events/tick"));
+
+    for (uint16_t count = 16; count <= MAX_TIMERS; count *= 4)
+    {
+        uint32_t fired = 0;
+        auto idleCost = MeasureTick(count, false, fired);
+        auto firingCost = MeasureTick(count, true, fired);
+
+        Serial.print(count);
+        Serial.print(F("\t"));
+        Serial.print(idleCost);
+        Serial.print(F("\t\t"));
+        Serial.print(firingCost);
+        Serial.print(F("\t\t\t"));
+        Serial.println((float)fired / TICKS);
+    }
+
+    TaskClock::StopVirtual();
+}
+
+
+void loop()
+{
+}